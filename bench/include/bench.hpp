@@ -0,0 +1,108 @@
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <thread>
+#include <vector>
+#include "tools.hpp"
+
+namespace bench {
+
+/* keep the compiler from optimizing away the value. */
+template <typename T>
+inline void doNotOptimize(const T& val) {
+    asm volatile("" : : "r,m"(val) : "memory");
+}
+
+/* run <func> for <n> iterations and return the average cost of each one in nanoseconds. */
+template <typename F>
+double nsPerOp(uint64_t n, F&& func) {
+    auto beg = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; i++) {
+        func(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - beg).count() / n;
+}
+
+/* how many TSC ticks elapse in one nanosecond, calibrated against the steady clock over <ms> milliseconds. */
+inline double tscPerNs(uint32_t ms = 100) {
+    auto beg = std::chrono::steady_clock::now();
+    uint64_t tsc_beg = test::rdtscp();
+    while (std::chrono::steady_clock::now() - beg < std::chrono::milliseconds(ms)) {}
+    uint64_t tsc_end = test::rdtscp();
+    auto end = std::chrono::steady_clock::now();
+    return (tsc_end - tsc_beg) / std::chrono::duration<double, std::nano>(end - beg).count();
+}
+
+/* pin the calling thread to <cpu>, return false if the CPU is not available. */
+inline bool pinThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/* run <producers> and <consumers> threads together until <total> messages passed the queue. */
+/* <push>(i) and <pop>() are tried until they succeed, return the throughput in messages per second. */
+/* producers are pinned to the leading ones of <cpus> and consumers to the following ones, if any given. */
+template <typename Push, typename Pop>
+double throughput(uint32_t producers, uint32_t consumers, uint64_t total, Push&& push, Pop&& pop,
+                  const std::vector<int>& cpus = {}) {
+    // every producer sends the same amount so the total may be trimmed a little
+    uint64_t per_producer = total / producers;
+    total = per_producer * producers;
+
+    std::atomic<uint32_t> ready = 0;
+    std::atomic<uint64_t> popped = 0;
+    const uint32_t threads = producers + consumers;
+
+    std::vector<std::thread> workers;
+    for (uint32_t p = 0; p < producers; p++) {
+        workers.emplace_back([&, p]() {
+            if (!cpus.empty()) pinThread(cpus[p % cpus.size()]);
+            ready.fetch_add(1);
+            while (ready.load() != threads + 1) {}
+            for (uint64_t i = p * per_producer; i < (p + 1) * per_producer; i++) {
+                while (!push(i)) {}
+            }
+        });
+    }
+    for (uint32_t c = 0; c < consumers; c++) {
+        workers.emplace_back([&, c]() {
+            if (!cpus.empty()) pinThread(cpus[(producers + c) % cpus.size()]);
+            ready.fetch_add(1);
+            while (ready.load() != threads + 1) {}
+            // count locally and only publish the progress when the queue looks empty
+            uint64_t local = 0;
+            while (true) {
+                if (pop()) {
+                    local++;
+                    continue;
+                }
+                popped.fetch_add(std::exchange(local, 0));
+                if (popped.load() >= total) break;
+            }
+        });
+    }
+
+    while (ready.load() != threads) {}
+    auto beg = std::chrono::steady_clock::now();
+    ready.store(threads + 1);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return total / std::chrono::duration<double>(end - beg).count();
+}
+
+/* print a single line of result in an aligned layout. */
+inline void report(const char* queue, const char* item, double value, const char* unit) {
+    std::printf("%-20s %-28s %10.2f %s\n", queue, item, value, unit);
+}
+
+}  // namespace bench
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace bench {
+
+/* log-linear histogram in the style of HdrHistogram. */
+/* values are grouped by their highest bit, and every group is split into 2^precision linear sub-buckets, */
+/* so the relative error of any recorded value is bounded by 2^-precision whatever its magnitude. */
+class Histogram {
+  private:
+    uint32_t precision_;
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+
+    /* values below 2^(precision + 1) are stored exactly, then each group shares one bucket every 2^shift. */
+    uint32_t index(uint64_t val) const {
+        uint64_t exact = 2ULL << precision_;
+        if (val < exact) return static_cast<uint32_t>(val);
+
+        uint32_t shift = std::bit_width(val) - 1 - precision_;
+        return (shift << precision_) + static_cast<uint32_t>(val >> shift);
+    }
+
+    /* the highest value which falls into bucket <idx>. */
+    uint64_t highest(uint32_t idx) const {
+        if (idx < (2U << precision_)) return idx;
+
+        uint32_t shift = (idx >> precision_) - 1;
+        uint64_t top = idx - (shift << precision_);
+        return ((top + 1) << shift) - 1;
+    }
+
+  public:
+    explicit Histogram(uint32_t precision = 5) : precision_(precision), counts_((65 - precision) << precision) {}
+
+    void record(uint64_t val) {
+        counts_[index(val)]++;
+        total_++;
+        min_ = std::min(min_, val);
+        max_ = std::max(max_, val);
+    }
+
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < counts_.size(); i++) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t min() const { return total_ == 0 ? 0 : min_; }
+    uint64_t max() const { return max_; }
+
+    /* the value below which <p> percent of the recorded values fall. */
+    uint64_t percentile(double p) const {
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100 * total_ + 0.5));
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(highest(i), max_);
+        }
+        return max_;
+    }
+
+    /* write the percentile distribution in the same columns as HdrHistogram's output. */
+    void dump(std::ostream& out) const {
+        out << "Value,Percentile,TotalCount,1/(1-Percentile)\n";
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < counts_.size(); i++) {
+            if (counts_[i] == 0) continue;
+            seen += counts_[i];
+            double ratio = static_cast<double>(seen) / total_;
+            out << highest(i) << "," << ratio << "," << seen << ",";
+            if (ratio < 1) {
+                out << 1 / (1 - ratio) << "\n";
+            } else {
+                out << "inf\n";
+            }
+        }
+    }
+};
+
+}  // namespace bench
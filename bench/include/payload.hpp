@@ -0,0 +1,19 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace bench {
+
+/* trivial payload of exactly <N> bytes, carrying the same leading fields as test::TrivialObj. */
+template <size_t N>
+struct Payload {
+    uint32_t uid;
+    uint32_t seq;
+    std::array<char, N - 8> pad;
+};
+static_assert(sizeof(Payload<64>) == 64 && sizeof(Payload<256>) == 256);
+static_assert(std::is_trivial<Payload<64>>());
+
+}  // namespace bench
@@ -0,0 +1,92 @@
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "backoff.hpp"
+#include "bench.hpp"
+#include "mpmc_sequence_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+static constexpr uint32_t capacity = 1024;
+
+/* logical CPUs ordered so that hyperthread siblings are adjacent, empty if no core runs more than one thread. */
+static std::vector<int> siblingOrder(uint32_t cpus) {
+    std::vector<int> order;
+    std::set<int> seen;
+    bool smt = false;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+        std::string list;
+        if (!(file >> list)) return {};
+
+        // the list looks like "0,4" or "0-1"
+        for (size_t pos = 0; pos < list.size();) {
+            size_t end = std::min(list.find(',', pos), list.size());
+            std::string range = list.substr(pos, end - pos);
+            size_t dash = range.find('-');
+            int first = std::stoi(range), last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int sibling = first; sibling <= last; sibling++) {
+                if (seen.insert(sibling).second) order.push_back(sibling);
+                smt |= sibling != static_cast<int>(cpu);
+            }
+            pos = end + 1;
+        }
+    }
+    return smt ? order : std::vector<int>{};
+}
+
+/* <producers> and <consumers> pass <total> messages through <Queue>, pinned to <cpus> if any, return M msgs/s. */
+template <typename Queue>
+double measure(uint32_t producers, uint32_t consumers, uint64_t total, const std::vector<int>& cpus = {}) {
+    Queue queue(capacity);
+    auto push = [&](uint64_t i) { return queue.push(TrivialObj{0, static_cast<uint32_t>(i)}); };
+    auto pop = [&]() { return queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj); }); };
+    return bench::throughput(producers, consumers, total, push, pop, cpus) / 1e6;
+}
+
+/* run every policy on both MPMC queues in one configuration. */
+template <BackoffPolicy... Policies>
+struct Matrix {
+    static void run(const char* config, uint32_t threads, uint64_t total, const std::vector<int>& cpus = {}) {
+        uint32_t producers = std::max(1U, threads / 2), consumers = std::max(1U, threads - producers);
+        const char* names[] = {"none", "pause", "exponential", "yield"};
+        char item[48];
+
+        uint32_t i = 0;
+        (
+            [&]() {
+                using Unique = MpmcUniqueQueue<TrivialObj, std::allocator<TrivialObj>, NoStats, Policies>;
+                using Sequence = MpmcSequenceQueue<TrivialObj, std::allocator<TrivialObj>, NoStats, Policies>;
+                std::snprintf(item, sizeof(item), "%s %ux%u %s", config, producers, consumers, names[i++]);
+                bench::report("MpmcUniqueQueue", item, measure<Unique>(producers, consumers, total, cpus), "M msgs/s");
+                bench::report("MpmcSequenceQueue", item, measure<Sequence>(producers, consumers, total, cpus),
+                              "M msgs/s");
+            }(),
+            ...);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    uint32_t cpus = std::max(2U, std::thread::hardware_concurrency());
+    using Policies = Matrix<NoBackoff, PauseBackoff, ExponentialBackoff<64>, YieldBackoff<16>>;
+
+    // every thread owns a logical CPU, and twice as many threads as logical CPUs
+    Policies::run("1/cpu", cpus, total);
+    Policies::run("2/cpu", 2 * cpus, total);
+
+    // every thread pinned next to a busy sibling on the same physical core
+    std::vector<int> siblings = siblingOrder(cpus);
+    if (siblings.empty()) {
+        std::printf("no hyperthread siblings found, skip the pinned configuration\n");
+    } else {
+        Policies::run("smt", static_cast<uint32_t>(siblings.size()), total, siblings);
+    }
+    return 0;
+}
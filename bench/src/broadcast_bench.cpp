@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+#include "bench.hpp"
+#include "broadcast_queue.hpp"
+#include "spsc_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+static constexpr uint32_t capacity = 4096;
+
+/* run <producer> and <consumers> readers together, return how many messages per second reach every reader. */
+template <typename Producer, typename Consumer>
+double fanOut(uint32_t consumers, uint64_t total, Producer&& producer, Consumer&& consumer) {
+    std::vector<std::thread> readers;
+    for (uint32_t c = 0; c < consumers; c++) {
+        readers.emplace_back([&, c]() { consumer(c, total); });
+    }
+
+    auto beg = std::chrono::steady_clock::now();
+    producer(total);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return total / std::chrono::duration<double>(end - beg).count();
+}
+
+/* every reader follows its own cursor on one ring, reading in batches. */
+double broadcast(uint32_t consumers, uint64_t total) {
+    BroadcastQueue<TrivialObj> queue(capacity, consumers);
+    for (uint32_t c = 0; c < consumers; c++) {
+        queue.subscribe();
+    }
+
+    return fanOut(
+        consumers, total,
+        [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                while (!queue.push(TrivialObj{0, static_cast<uint32_t>(i)})) {}
+            }
+        },
+        [&](uint32_t c, uint64_t n) {
+            for (uint64_t i = 0; i < n;) {
+                i += queue.pop_bulk(c, [](const TrivialObj& obj) { bench::doNotOptimize(obj.seq); }, 256);
+            }
+        });
+}
+
+/* the producer copies every message into one SPSC queue per reader. */
+double copies(uint32_t consumers, uint64_t total) {
+    std::vector<std::unique_ptr<SpscQueue<TrivialObj>>> queues;
+    for (uint32_t c = 0; c < consumers; c++) {
+        queues.push_back(std::make_unique<SpscQueue<TrivialObj>>(capacity));
+    }
+
+    return fanOut(
+        consumers, total,
+        [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                for (auto& queue : queues) {
+                    while (!queue->push(TrivialObj{0, static_cast<uint32_t>(i)})) {}
+                }
+            }
+        },
+        [&](uint32_t c, uint64_t n) {
+            for (uint64_t i = 0; i < n;) {
+                i += queues[c]->pop_bulk([](TrivialObj& obj) { bench::doNotOptimize(obj.seq); }, 256);
+            }
+        });
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16'000'000;
+
+    char item[32];
+    for (uint32_t consumers : {1, 2, 4}) {
+        std::snprintf(item, sizeof(item), "1 -> %u readers", consumers);
+        bench::report("BroadcastQueue", item, 1e9 / broadcast(consumers, total), "ns/msg");
+        bench::report("SpscQueue copies", item, 1e9 / copies(consumers, total), "ns/msg");
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "mpmc_shared_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+static constexpr uint32_t capacity = 4096;
+
+/* one producer and one consumer transfer <total> messages in batches of <batch>, 1 means single interfaces. */
+template <typename Queue>
+double measure(uint32_t batch, uint64_t total) {
+    Queue queue(capacity);
+    std::vector<TrivialObj> objs(batch);
+
+    auto push = [&](uint64_t i) {
+        if (batch == 1) return queue.push(TrivialObj{0, static_cast<uint32_t>(i)});
+        // only the last element of a batch is counted, so the rest of the batch must get in first
+        if (i % batch != batch - 1) return true;
+        for (auto it = objs.begin(); it != objs.end();) {
+            it += queue.push_bulk(it, objs.end());
+        }
+        return true;
+    };
+
+    uint32_t pending = 0;
+    auto pop = [&]() {
+        if (pending == 0) {
+            pending = batch == 1 ? queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj); })
+                                 : queue.pop_bulk([](TrivialObj& obj) { bench::doNotOptimize(obj); }, batch);
+        }
+        if (pending == 0) return false;
+        pending--;
+        return true;
+    };
+
+    return bench::throughput(1, 1, total, push, pop);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16'000'000;
+
+    char item[32];
+    for (uint32_t batch : {1, 8, 32, 256}) {
+        std::snprintf(item, sizeof(item), "batch %u", batch);
+        bench::report("SpscQueue", item, 1e9 / measure<SpscQueue<TrivialObj>>(batch, total), "ns/msg");
+        bench::report("MpmcUniqueQueue", item, 1e9 / measure<MpmcUniqueQueue<TrivialObj>>(batch, total), "ns/msg");
+        bench::report("MpmcSharedQueue", item, 1e9 / measure<MpmcSharedQueue<TrivialObj>>(batch, total), "ns/msg");
+    }
+    return 0;
+}
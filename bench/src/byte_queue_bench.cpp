@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench.hpp"
+#include "byte_queue.hpp"
+#include "payload.hpp"
+#include "spsc_queue.hpp"
+
+using namespace lfcq;
+
+// every queue gets the same memory for its ring
+static constexpr uint32_t ring_bytes = 64 * 1024;
+static constexpr uint32_t max_frame = 1024;
+
+/* frame lengths skewed towards small ones, as in a typical protocol, up to <max_frame>. */
+static std::vector<uint32_t> frameLengths() {
+    std::vector<uint32_t> lengths(4096);
+    uint32_t seed = 2463534242U;
+    for (auto& length : lengths) {
+        seed ^= seed << 13, seed ^= seed >> 17, seed ^= seed << 5;
+        uint32_t r = seed % (max_frame - 16);
+        length = 16 + r * r / (max_frame - 16);
+    }
+    return lengths;
+}
+
+/* frames written in place into a byte ring and read in place from it. */
+double byteRing(const std::vector<uint32_t>& lengths, const std::vector<std::byte>& frame, uint64_t total) {
+    SpscByteQueue queue(ring_bytes);
+    auto push = [&](uint64_t i) {
+        std::span<std::byte> msg = queue.reserve(lengths[i % lengths.size()]);
+        if (msg.data() == nullptr) return false;
+        std::memcpy(msg.data(), frame.data(), msg.size());
+        queue.commit(msg);
+        return true;
+    };
+    auto pop = [&]() {
+        std::span<const std::byte> msg = queue.read();
+        if (msg.data() == nullptr) return false;
+        bench::doNotOptimize(msg[msg.size() - 1]);
+        queue.release();
+        return true;
+    };
+    return bench::throughput(1, 1, total, push, pop) / 1e6;
+}
+
+/* every slot sized for the largest frame, so the same memory holds far fewer frames. */
+double fixedSlots(const std::vector<uint32_t>& lengths, const std::vector<std::byte>& frame, uint64_t total) {
+    using Slot = bench::Payload<max_frame + 8>;
+    SpscQueue<Slot> queue(ring_bytes / sizeof(Slot));
+    auto push = [&](uint64_t i) {
+        return queue.push([&](Slot& slot) {
+            slot.uid = lengths[i % lengths.size()];
+            std::memcpy(slot.pad.data(), frame.data(), slot.uid);
+        });
+    };
+    auto pop = [&]() { return queue.pop([](Slot& slot) { bench::doNotOptimize(slot.pad[slot.uid - 1]); }); };
+    return bench::throughput(1, 1, total, push, pop) / 1e6;
+}
+
+/* pointers to heap buffers, which cost an allocation and a free for every frame. */
+double heapBuffers(const std::vector<uint32_t>& lengths, const std::vector<std::byte>& frame, uint64_t total) {
+    SpscQueue<std::vector<std::byte>*> queue(ring_bytes / sizeof(void*));
+    auto push = [&](uint64_t i) {
+        uint32_t length = lengths[i % lengths.size()];
+        auto buffer = new std::vector<std::byte>(frame.begin(), frame.begin() + length);
+        if (queue.push(buffer)) return true;
+        delete buffer;
+        return false;
+    };
+    auto pop = [&]() {
+        return queue.pop([](std::vector<std::byte>*& buffer) {
+            bench::doNotOptimize(buffer->back());
+            delete buffer;
+        });
+    };
+    return bench::throughput(1, 1, total, push, pop) / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    std::vector<uint32_t> lengths = frameLengths();
+    std::vector<std::byte> frame(max_frame, std::byte{0x5a});
+    uint64_t bytes = 0;
+    for (uint32_t length : lengths) {
+        bytes += length;
+    }
+    std::printf("frames of 16 to %u bytes, %lu on average, rings of %u KiB\n", max_frame, bytes / lengths.size(),
+                ring_bytes / 1024);
+
+    bench::report("SpscByteQueue", "in place", byteRing(lengths, frame, total), "M msgs/s");
+    bench::report("SpscQueue", "slots of the largest frame", fixedSlots(lengths, frame, total), "M msgs/s");
+    bench::report("SpscQueue", "pointers to heap buffers", heapBuffers(lengths, frame, total), "M msgs/s");
+    return 0;
+}
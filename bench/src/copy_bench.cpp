@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <utility>
+
+#include "bench.hpp"
+#include "payload.hpp"
+#include "spsc_queue.hpp"
+
+using namespace lfcq;
+
+static constexpr uint32_t capacity = 4096;
+static constexpr uint32_t batch = 32;
+
+/* how bulk interfaces move a batch in and out of the queue. */
+enum class Path {
+    Element,    // handles assigning element by element
+    Memcpy,     // contiguous buffers copied with memcpy
+    Streaming,  // streamed in with non-temporal stores, copied out with memcpy
+};
+
+/* push the whole of <in> through <path>, retrying while the queue is full. */
+template <typename Record>
+void pushBatch(SpscQueue<Record>& queue, std::vector<Record>& in, Path path) {
+    for (Record *it = in.data(), *end = it + in.size(); it != end;) {
+        if (path == Path::Element) {
+            // the handle advances <it> by itself
+            queue.push_bulk([&it](Record& slot) { slot = *it++; }, end - it);
+        } else if (path == Path::Memcpy) {
+            it += queue.push_bulk(it, end);
+        } else {
+            it += queue.template push_bulk<CopyMode::Streaming>(it, end);
+        }
+    }
+}
+
+/* pop at most a batch into <out> through <path>, return how many records were popped. */
+template <typename Record>
+uint32_t popBatch(SpscQueue<Record>& queue, std::vector<Record>& out, Path path) {
+    uint32_t cnt;
+    if (path == Path::Element) {
+        Record* it = out.data();
+        cnt = queue.pop_bulk([&it](Record& obj) { *it++ = obj; }, out.size());
+    } else {
+        cnt = queue.pop_bulk(out.data(), out.size());
+    }
+    bench::doNotOptimize(out[0]);
+    return cnt;
+}
+
+/* one producer and one consumer transfer <total> records of <N> bytes in batches, return GB/s. */
+template <size_t N>
+double transfer(Path path, uint64_t total) {
+    using Record = bench::Payload<N>;
+    SpscQueue<Record> queue(capacity);
+    std::vector<Record> in(batch, Record{}), out(batch, Record{});
+
+    auto push = [&](uint64_t i) {
+        // only the last record of a batch is counted, so the rest of the batch must get in first
+        if (i % batch == batch - 1) pushBatch(queue, in, path);
+        return true;
+    };
+
+    uint32_t pending = 0;
+    auto pop = [&]() {
+        if (pending == 0) pending = popBatch(queue, out, path);
+        if (pending == 0) return false;
+        pending--;
+        return true;
+    };
+
+    return bench::throughput(1, 1, total, push, pop) * N / 1e9;
+}
+
+/* a single thread pushes a batch of <N>-byte records and pops it back, return ns per record. */
+/* without a second thread it measures the copies alone, which on few cores are hidden by scheduling. */
+template <size_t N>
+double copyCost(Path path, uint64_t total) {
+    using Record = bench::Payload<N>;
+    SpscQueue<Record> queue(capacity);
+    std::vector<Record> in(batch, Record{}), out(batch, Record{});
+
+    return bench::nsPerOp(total / batch, [&](uint64_t) {
+               pushBatch(queue, in, path);
+               popBatch(queue, out, path);
+           }) /
+           batch;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8'000'000;
+
+    for (auto [path, name] : {std::pair{Path::Element, "per element"}, std::pair{Path::Memcpy, "memcpy"},
+                              std::pair{Path::Streaming, "streaming stores"}}) {
+        bench::report("SpscQueue 64 B", name, transfer<64>(path, total), "GB/s");
+        bench::report("SpscQueue 1 KiB", name, transfer<1024>(path, total / 8), "GB/s");
+        bench::report("copy only 64 B", name, copyCost<64>(path, total), "ns/msg");
+        bench::report("copy only 1 KiB", name, copyCost<1024>(path, total / 8), "ns/msg");
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "bench.hpp"
+#include "coroutine.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+
+using namespace lfcq;
+
+/* seconds taken by <func>. */
+template <typename F>
+double elapsed(F&& func) {
+    auto beg = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+}
+
+template <typename Queue, typename S>
+AsyncTask produce(Queue& queue, S& scheduler, uint64_t total) {
+    for (uint64_t i = 0; i < total; i++) {
+        co_await queue.async_push(i, scheduler);
+    }
+}
+
+template <typename Queue, typename S>
+AsyncTask consume(Queue& queue, S& scheduler, uint64_t total) {
+    for (uint64_t i = 0; i < total; i++) {
+        bench::doNotOptimize(co_await queue.async_pop(scheduler));
+    }
+}
+
+/* bounce a message between <ping> and <pong> <total> times, the one starting the round. */
+template <typename Queue, typename S>
+AsyncTask serve(Queue& ping, Queue& pong, S& scheduler, uint64_t total) {
+    for (uint64_t i = 0; i < total; i++) {
+        co_await ping.async_push(i, scheduler);
+        bench::doNotOptimize(co_await pong.async_pop(scheduler));
+    }
+}
+
+/* the one answering the round. */
+template <typename Queue, typename S>
+AsyncTask answer(Queue& ping, Queue& pong, S& scheduler, uint64_t total) {
+    for (uint64_t i = 0; i < total; i++) {
+        co_await pong.async_push(co_await ping.async_pop(scheduler), scheduler);
+    }
+}
+
+/* a producer thread and a consumer thread block in <push_wait> and <pop_wait>, return million msgs/s. */
+template <typename Queue>
+double threadTransfer(uint32_t capacity, uint64_t total) {
+    Queue queue(capacity);
+    double secs = elapsed([&]() {
+        std::thread producer([&]() {
+            for (uint64_t i = 0; i < total; i++) {
+                queue.push_wait(i);
+            }
+        });
+        for (uint64_t i = 0; i < total; i++) {
+            queue.pop_wait([](uint64_t& obj) { bench::doNotOptimize(obj); });
+        }
+        producer.join();
+    });
+    return total / secs / 1e6;
+}
+
+/* a producer and a consumer coroutine on one loop, return million msgs/s. */
+template <typename Queue>
+double loopTransfer(uint32_t capacity, uint64_t total) {
+    Queue queue(capacity);
+    LoopScheduler loop;
+    loop.spawn(consume(queue, loop, total));
+    loop.spawn(produce(queue, loop, total));
+    return total / elapsed([&]() { loop.run(); }) / 1e6;
+}
+
+/* a producer and a consumer coroutine on loops of their own threads, return million msgs/s. */
+template <typename Queue>
+double crossTransfer(uint32_t capacity, uint64_t total) {
+    Queue queue(capacity);
+    LoopScheduler producer, consumer;
+    producer.spawn(produce(queue, producer, total));
+    consumer.spawn(consume(queue, consumer, total));
+    double secs = elapsed([&]() {
+        std::thread thread([&]() { producer.run(); });
+        consumer.run();
+        thread.join();
+    });
+    return total / secs / 1e6;
+}
+
+/* two threads bounce a message through two queues blocking in <pop_wait>, return ns per round trip. */
+template <typename Queue>
+double threadRoundTrip(uint64_t total) {
+    Queue ping(1), pong(1);
+    double secs = elapsed([&]() {
+        std::thread peer([&]() {
+            uint64_t val = 0;
+            for (uint64_t i = 0; i < total; i++) {
+                ping.pop_wait([&val](uint64_t& obj) { val = obj; });
+                pong.push_wait(val);
+            }
+        });
+        for (uint64_t i = 0; i < total; i++) {
+            ping.push_wait(i);
+            pong.pop_wait([](uint64_t& obj) { bench::doNotOptimize(obj); });
+        }
+        peer.join();
+    });
+    return secs * 1e9 / total;
+}
+
+/* two coroutines on one loop bounce a message, return ns per round trip. */
+template <typename Queue>
+double loopRoundTrip(uint64_t total) {
+    Queue ping(1), pong(1);
+    LoopScheduler loop;
+    loop.spawn(answer(ping, pong, loop, total));
+    loop.spawn(serve(ping, pong, loop, total));
+    return elapsed([&]() { loop.run(); }) * 1e9 / total;
+}
+
+/* two coroutines on loops of their own threads bounce a message, return ns per round trip. */
+template <typename Queue>
+double crossRoundTrip(uint64_t total) {
+    Queue ping(1), pong(1);
+    LoopScheduler server, answerer;
+    server.spawn(serve(ping, pong, server, total));
+    answerer.spawn(answer(ping, pong, answerer, total));
+    double secs = elapsed([&]() {
+        std::thread thread([&]() { answerer.run(); });
+        server.run();
+        thread.join();
+    });
+    return secs * 1e9 / total;
+}
+
+template <typename Queue>
+void measure(const char* name, uint64_t total) {
+    char item[32];
+    for (uint32_t capacity : {16U, 1024U}) {
+        std::snprintf(item, sizeof(item), "%u threads wait", capacity);
+        bench::report(name, item, threadTransfer<Queue>(capacity, total), "M msgs/s");
+        std::snprintf(item, sizeof(item), "%u coroutines 1 loop", capacity);
+        bench::report(name, item, loopTransfer<Queue>(capacity, total), "M msgs/s");
+        std::snprintf(item, sizeof(item), "%u coroutines 2 loops", capacity);
+        bench::report(name, item, crossTransfer<Queue>(capacity, total), "M msgs/s");
+    }
+
+    // round trips are far slower than streaming, so fewer of them
+    bench::report(name, "round trip threads wait", threadRoundTrip<Queue>(total / 20), "ns/rtt");
+    bench::report(name, "round trip 1 loop", loopRoundTrip<Queue>(total / 20), "ns/rtt");
+    bench::report(name, "round trip 2 loops", crossRoundTrip<Queue>(total / 20), "ns/rtt");
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    measure<SpscQueue<uint64_t, std::allocator<uint64_t>, NoStats, true>>("SpscQueue", total);
+    measure<MpmcUniqueQueue<uint64_t, std::allocator<uint64_t>, NoStats, PauseBackoff, true>>("MpmcUniqueQueue", total);
+    return 0;
+}
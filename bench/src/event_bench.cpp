@@ -0,0 +1,113 @@
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "bench.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "stats.hpp"
+
+using namespace lfcq;
+
+static constexpr uint32_t capacity = 1024;
+
+/* how the producer paces its messages. */
+struct Load {
+    const char* name;
+    uint32_t burst;  // messages pushed back to back
+    uint32_t gap;    // microseconds between bursts, 0 for none
+};
+
+/* push <total> messages through <push>(i) at the pace of <load>. */
+template <typename Push>
+void produce(uint64_t total, const Load& load, Push&& push) {
+    for (uint64_t i = 0; i < total;) {
+        for (uint32_t j = 0; j < load.burst && i < total; j++, i++) {
+            while (!push(i)) {
+                std::this_thread::yield();
+            }
+        }
+        if (load.gap != 0) std::this_thread::sleep_for(std::chrono::microseconds(load.gap));
+    }
+}
+
+/* system calls per 1000 messages of an epoll consumer which arms the queue once drained. */
+/* the fd is written only when armed and read at most once per write, so the count is an upper bound. */
+template <typename Queue>
+double armed(uint64_t total, const Load& load) {
+    Queue queue(capacity);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, queue.fd(), &event);
+
+    std::thread producer([&]() { produce(total, load, [&](uint64_t i) { return queue.push(i); }); });
+    uint64_t popped = 0, waits = 0;
+    while (popped < total) {
+        while (queue.pop([](uint64_t& obj) { bench::doNotOptimize(obj); })) {
+            popped++;
+        }
+        if (popped == total || !queue.arm()) continue;
+        epoll_wait(epfd, &event, 1, -1);
+        waits++;
+    }
+    producer.join();
+    close(epfd);
+    return 1000.0 * (waits + 2 * queue.stats().event_signals) / total;
+}
+
+/* system calls per 1000 messages when every push writes an eventfd of its own, and every wake-up reads it. */
+template <typename Queue>
+double naive(uint64_t total, const Load& load) {
+    Queue queue(capacity);
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, efd, &event);
+
+    std::thread producer([&]() {
+        produce(total, load, [&](uint64_t i) { return queue.push(i) && eventfd_write(efd, 1) == 0; });
+    });
+    uint64_t popped = 0, calls = 0;
+    while (popped < total) {
+        epoll_wait(epfd, &event, 1, -1);
+        eventfd_t cnt;
+        eventfd_read(efd, &cnt);
+        calls += 2;
+        while (queue.pop([](uint64_t& obj) { bench::doNotOptimize(obj); })) {
+            popped++;
+        }
+    }
+    producer.join();
+    close(epfd);
+    close(efd);
+    return 1000.0 * (calls + total) / total;
+}
+
+template <typename Queue>
+void measure(const char* name, uint64_t total) {
+    // a sleep of the sparse load takes far longer than the consumer needs to drain the queue
+    const Load loads[] = {{"saturated", 1, 0}, {"sparse", 1, 1}, {"bursts of 64", 64, 200}};
+    char item[32];
+    for (const Load& load : loads) {
+        // paced loads sleep, so they get fewer messages
+        uint64_t n = load.gap == 0 ? total : total / 20;
+        std::snprintf(item, sizeof(item), "%s armed", load.name);
+        bench::report(name, item, armed<Queue>(n, load), "syscalls/1k msgs");
+        std::snprintf(item, sizeof(item), "%s every push", load.name);
+        bench::report(name, item, naive<Queue>(n, load), "syscalls/1k msgs");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+
+    measure<SpscQueue<uint64_t, std::allocator<uint64_t>, ShardedStats<>, true>>("SpscQueue", total);
+    measure<MpmcUniqueQueue<uint64_t, std::allocator<uint64_t>, ShardedStats<>, PauseBackoff, true>>("MpmcUniqueQueue",
+                                                                                                  total);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+#include "bench.hpp"
+#include "executor.hpp"
+#include "histogram.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "tools.hpp"
+
+using namespace lfcq;
+
+/* time <submit>(n) together with draining every task submitted, return ns per task. */
+template <typename Submit>
+double drain(uint64_t total, Submit&& submit) {
+    auto beg = std::chrono::steady_clock::now();
+    submit(total);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - beg).count() / total;
+}
+
+/* the owner posts empty tasks through the inboxes. */
+double ownerThroughput(uint32_t workers, uint64_t total) {
+    return drain(total, [&](uint64_t n) {
+        ExecutorOptions options;
+        options.workers = workers;
+        Executor executor(options);
+        for (uint64_t i = 0; i < n; i++) {
+            executor.post([]() {});
+        }
+    });
+}
+
+/* a thread other than the owner posts empty tasks through the overflow queue. */
+double foreignThroughput(uint32_t workers, uint64_t total) {
+    return drain(total, [&](uint64_t n) {
+        ExecutorOptions options;
+        options.workers = workers;
+        Executor executor(options);
+        std::thread([&]() {
+            for (uint64_t i = 0; i < n; i++) {
+                executor.post([]() {});
+            }
+        }).join();
+    });
+}
+
+/* the pool everybody writes by hand: heap-allocated std::function tasks on one MPMC queue, */
+/* and workers spinning on <pop>. */
+double handWritten(uint32_t workers, uint64_t total) {
+    return drain(total, [&](uint64_t n) {
+        MpmcUniqueQueue<std::function<void()>*> queue(4096);
+        std::atomic<bool> stopping = false;
+
+        std::vector<std::thread> threads;
+        for (uint32_t w = 0; w < workers; w++) {
+            threads.emplace_back([&]() {
+                std::function<void()>* task;
+                while (true) {
+                    if (queue.pop([&](std::function<void()>*& obj) { task = obj; })) {
+                        (*task)();
+                        delete task;
+                    } else if (stopping) {
+                        return;
+                    }
+                }
+            });
+        }
+
+        for (uint64_t i = 0; i < n; i++) {
+            auto task = new std::function<void()>([]() {});
+            while (!queue.push(task)) {}
+        }
+        stopping = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    });
+}
+
+/* round trip of an empty task from <submit> to <get>, with workers parking according to <idle>. */
+bench::Histogram latency(uint64_t total, const WaitPolicy& idle, double tsc_per_ns) {
+    ExecutorOptions options;
+    options.workers = 1;
+    options.idle = idle;
+    Executor executor(options);
+
+    bench::Histogram histogram;
+    for (uint64_t i = 0; i < total; i++) {
+        uint64_t beg = test::rdtscp();
+        executor.submit([]() { return 0; }).get();
+        histogram.record((test::rdtscp() - beg) / tsc_per_ns);
+    }
+    return histogram;
+}
+
+static void report(const char* item, const bench::Histogram& hist) {
+    std::printf("%-20s %-24s", "Executor", item);
+    for (double p : {50.0, 99.0, 99.9}) {
+        std::printf(" p%-5g %8lu", p, hist.percentile(p));
+    }
+    std::printf(" max %10lu ns\n", hist.max());
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4'000'000;
+
+    char item[32];
+    for (uint32_t workers : {1, 2, 4}) {
+        std::snprintf(item, sizeof(item), "submit %u workers", workers);
+        bench::report("Executor owner", item, ownerThroughput(workers, total), "ns/task");
+        bench::report("Executor foreign", item, foreignThroughput(workers, total), "ns/task");
+        bench::report("hand-written pool", item, handWritten(workers, total), "ns/task");
+    }
+
+    double tsc_per_ns = bench::tscPerNs();
+    report("round trip spinning", latency(total / 40, WaitPolicy(), tsc_per_ns));
+    report("round trip parked", latency(total / 40, WaitPolicy{0, 0, 0}, tsc_per_ns));
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <cstring>
+
+#include "bench.hpp"
+#include "mpmc_shared_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+// operations are measured on a single thread so only the cost of the call itself shows up
+static constexpr uint64_t iterations = 10'000'000;
+static constexpr uint32_t capacity = 1024;
+
+/* push then pop one element per iteration through type-erased handles, as the old interface did. */
+template <typename Queue>
+double typeErased(Queue& queue) {
+    uint32_t sum = 0;
+    double cost = bench::nsPerOp(iterations, [&](uint64_t i) {
+        queue.push(PushHandle<TrivialObj>([i](TrivialObj& obj) {
+            obj.uid = 0;
+            obj.seq = static_cast<uint32_t>(i);
+        }));
+        queue.pop(PopHandle<TrivialObj>([&sum](TrivialObj& obj) { sum += obj.seq; }));
+    });
+    bench::doNotOptimize(sum);
+    return cost;
+}
+
+/* push then pop one element per iteration through templated handles. */
+template <typename Queue>
+double templated(Queue& queue) {
+    uint32_t sum = 0;
+    double cost = bench::nsPerOp(iterations, [&](uint64_t i) {
+        queue.push([i](TrivialObj& obj) {
+            obj.uid = 0;
+            obj.seq = static_cast<uint32_t>(i);
+        });
+        queue.pop([&sum](TrivialObj& obj) { sum += obj.seq; });
+    });
+    bench::doNotOptimize(sum);
+    return cost;
+}
+
+/* same as above but the pop handle captures more than the small buffer of std::function holds. */
+template <typename Queue>
+double largeCapture(Queue& queue, bool erased) {
+    char pad[64] = {};
+    uint32_t sum = 0;
+    auto handle = [&sum, pad](TrivialObj& obj) { sum += obj.seq + pad[obj.seq & 63]; };
+
+    double cost = bench::nsPerOp(iterations, [&](uint64_t i) {
+        queue.emplace(0U, static_cast<uint32_t>(i));
+        if (erased) {
+            queue.pop(PopHandle<TrivialObj>(handle));
+        } else {
+            queue.pop(handle);
+        }
+    });
+    bench::doNotOptimize(sum);
+    return cost;
+}
+
+template <typename Queue>
+void run(const char* name) {
+    Queue queue(capacity);
+    bench::report(name, "std::function", typeErased(queue), "ns/op");
+    bench::report(name, "template", templated(queue), "ns/op");
+    bench::report(name, "std::function (large)", largeCapture(queue, true), "ns/op");
+    bench::report(name, "template (large)", largeCapture(queue, false), "ns/op");
+}
+
+int main() {
+    run<SpscQueue<TrivialObj>>("SpscQueue");
+    run<MpmcUniqueQueue<TrivialObj>>("MpmcUniqueQueue");
+    run<MpmcSharedQueue<TrivialObj>>("MpmcSharedQueue");
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "huge_page_allocator.hpp"
+#include "payload.hpp"
+#include "spsc_queue.hpp"
+
+using namespace lfcq;
+
+using Message = bench::Payload<64>;
+
+/* 64 MiB of ring by default, well beyond the last level cache of common parts. */
+static uint32_t capacity = 1 << 20;
+
+/* construct the queue, then pass the ring once in one thread, then stream <total> messages through it. */
+/* the first pass takes every page fault of a lazily touched ring, the stream shows the cost of TLB misses. */
+template <typename Allocator>
+void measure(const char* name, const Allocator& alloc, uint64_t total) {
+    auto beg = std::chrono::steady_clock::now();
+    SpscQueue<Message, Allocator> queue(capacity, alloc);
+    auto end = std::chrono::steady_clock::now();
+    bench::report(name, "construct", std::chrono::duration<double, std::milli>(end - beg).count(), "ms");
+
+    double first = bench::nsPerOp(capacity, [&](uint64_t i) {
+        queue.emplace(Message{0, static_cast<uint32_t>(i), {}});
+    });
+    while (queue.pop([](Message& obj) { bench::doNotOptimize(obj.seq); })) {}
+    bench::report(name, "first pass", first, "ns/msg");
+
+    auto push = [&](uint64_t i) { return queue.emplace(Message{0, static_cast<uint32_t>(i), {}}); };
+    auto pop = [&]() { return queue.pop([](Message& obj) { bench::doNotOptimize(obj.seq); }); };
+    bench::report(name, "stream 1x1", 1e9 / bench::throughput(1, 1, total, push, pop), "ns/msg");
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16'000'000;
+    if (argc > 2) capacity = std::strtoul(argv[2], nullptr, 10);
+    int node = argc > 3 ? std::atoi(argv[3]) : -1;
+
+    measure("std::allocator", std::allocator<Message>(), total);
+    measure("mmap lazy", HugePageAllocator<Message>({false, false, false, node}), total);
+    measure("mmap prefault", HugePageAllocator<Message>({false, true, false, node}), total);
+    measure("huge lazy", HugePageAllocator<Message>({true, false, false, node}), total);
+    measure("huge prefault", HugePageAllocator<Message>({true, true, false, node}), total);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "mpmc_shared_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+// built twice, the packed binary defines LFCQ_CACHELINE_SIZE=4 so all indices share cache lines
+#if LFCQ_CACHELINE_SIZE == 4
+static constexpr const char* layout = "packed";
+#else
+static constexpr const char* layout = "isolated";
+#endif
+
+static constexpr uint32_t capacity = 4096;
+
+template <typename Queue>
+double measure(uint32_t threads, uint64_t total) {
+    Queue queue(capacity);
+    auto push = [&](uint64_t i) { return queue.emplace(0U, static_cast<uint32_t>(i)); };
+    auto pop = [&]() { return queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj); }); };
+    return bench::throughput(threads / 2, threads / 2, total, push, pop);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4'000'000;
+
+    char item[32];
+    std::snprintf(item, sizeof(item), "%s 2 threads", layout);
+    bench::report("SpscQueue", item, measure<SpscQueue<TrivialObj>>(2, total) / 1e6, "M msg/s");
+
+    for (uint32_t threads : {2, 4, 8}) {
+        std::snprintf(item, sizeof(item), "%s %u threads", layout, threads);
+        bench::report("MpmcUniqueQueue", item, measure<MpmcUniqueQueue<TrivialObj>>(threads, total) / 1e6, "M msg/s");
+        bench::report("MpmcSharedQueue", item, measure<MpmcSharedQueue<TrivialObj>>(threads, total) / 1e6, "M msg/s");
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "bench.hpp"
+#include "mpmc_sequence_queue.hpp"
+#include "mpmc_shared_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "payload.hpp"
+#include "spsc_queue.hpp"
+#include "types.hpp"
+#include "unbounded_queue.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+/* options of the sweep, each list is given as comma separated values. */
+/*   --threads=1,2,4       counts of producers and of consumers, every combination within --max-threads */
+/*   --max-threads=N       upper bound of producers + consumers, the number of cores by default */
+/*   --capacities=1024     queue capacities */
+/*   --payloads=8,64,256,nontrivial */
+/*   --queues=spsc,unique,shared,sequence,unbounded   the capacity is the segment size of unbounded */
+/*   --messages=N          messages passed in each run */
+/*   --pin=0,1,2 | --pin=auto   CPUs to pin producers then consumers to */
+/*   --format=csv | json   --output=path */
+struct Config {
+    std::vector<uint32_t> threads;
+    uint32_t max_threads = std::max(2U, std::thread::hardware_concurrency());
+    std::vector<uint32_t> capacities = {1024, 65536};
+    std::vector<std::string> payloads = {"8", "64", "256", "nontrivial"};
+    std::vector<std::string> queues = {"spsc", "unique", "shared", "sequence"};
+    uint64_t messages = 4'000'000;
+    std::vector<int> cpus;
+    std::string format = "csv";
+    std::string output;
+};
+
+struct Result {
+    std::string queue;
+    uint32_t producers;
+    uint32_t consumers;
+    uint32_t capacity;
+    std::string payload;
+    uint64_t messages;
+    double rate;
+};
+
+static std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+static std::vector<uint32_t> splitNumbers(const std::string& list) {
+    std::vector<uint32_t> numbers;
+    for (auto& item : split(list)) {
+        numbers.push_back(std::stoul(item));
+    }
+    return numbers;
+}
+
+static Config parse(int argc, char* argv[]) {
+    Config config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        std::string key = arg.substr(0, eq), value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--threads") {
+            config.threads = splitNumbers(value);
+        } else if (key == "--max-threads") {
+            config.max_threads = std::stoul(value);
+        } else if (key == "--capacities") {
+            config.capacities = splitNumbers(value);
+        } else if (key == "--payloads") {
+            config.payloads = split(value);
+        } else if (key == "--queues") {
+            config.queues = split(value);
+        } else if (key == "--messages") {
+            config.messages = std::stoull(value);
+        } else if (key == "--pin" && value == "auto") {
+            for (uint32_t cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+                config.cpus.push_back(cpu);
+            }
+        } else if (key == "--pin") {
+            for (auto cpu : splitNumbers(value)) {
+                config.cpus.push_back(cpu);
+            }
+        } else if (key == "--format") {
+            config.format = value;
+        } else if (key == "--output") {
+            config.output = value;
+        } else {
+            std::cerr << "unknown option: " << arg << std::endl;
+            std::exit(1);
+        }
+    }
+
+    // powers of 2 up to the number of cores by default
+    if (config.threads.empty()) {
+        for (uint32_t n = 1; n < config.max_threads; n *= 2) {
+            config.threads.push_back(n);
+        }
+    }
+    return config;
+}
+
+/* the message <seq>, payloads with their padding spelled out so no field is left without an initializer. */
+template <typename T>
+T message(uint32_t seq) {
+    if constexpr (requires { T{0U, seq, {}}; }) {
+        return T{0U, seq, {}};
+    } else {
+        return T{0U, seq};
+    }
+}
+
+/* pass the messages through one queue and record the throughput. */
+template <template <typename...> class Queue, typename T>
+Result measure(const Config& config, const char* queue_name, const std::string& payload, uint32_t producers,
+               uint32_t consumers, uint32_t capacity) {
+    Queue<T> queue(capacity);
+    auto push = [&](uint64_t i) { return queue.push(message<T>(static_cast<uint32_t>(i))); };
+    auto pop = [&]() { return queue.pop([](T& obj) { bench::doNotOptimize(obj.seq); }); };
+
+    double rate = bench::throughput(producers, consumers, config.messages, push, pop, config.cpus);
+    return {queue_name, producers, consumers, capacity, payload, config.messages / producers * producers, rate};
+}
+
+/* sweep thread counts and capacities for one queue with one payload. */
+template <template <typename...> class Queue, typename T>
+void sweep(const Config& config, const char* queue_name, const std::string& payload, bool single,
+           std::vector<Result>& results) {
+    for (uint32_t capacity : config.capacities) {
+        for (uint32_t producers : config.threads) {
+            for (uint32_t consumers : config.threads) {
+                if (single && (producers != 1 || consumers != 1)) continue;
+                if (producers + consumers > std::max(2U, config.max_threads)) continue;
+
+                results.push_back(measure<Queue, T>(config, queue_name, payload, producers, consumers, capacity));
+                auto& result = results.back();
+                std::cerr << result.queue << " " << result.producers << "x" << result.consumers << " cap "
+                          << result.capacity << " payload " << result.payload << ": " << result.rate / 1e6
+                          << " M msg/s" << std::endl;
+            }
+        }
+    }
+}
+
+// the queues with a non-type parameter are passed through aliases of their defaults
+template <typename T>
+using DefaultSpscQueue = SpscQueue<T>;
+template <typename T>
+using DefaultMpmcUniqueQueue = MpmcUniqueQueue<T>;
+template <typename T>
+using DefaultMpmcSharedQueue = MpmcSharedQueue<T>;
+
+template <template <typename...> class Queue>
+void sweepPayloads(const Config& config, const char* queue_name, bool single, std::vector<Result>& results) {
+    for (auto& payload : config.payloads) {
+        if (payload == "8") {
+            sweep<Queue, TrivialObj>(config, queue_name, payload, single, results);
+        } else if (payload == "64") {
+            sweep<Queue, bench::Payload<64>>(config, queue_name, payload, single, results);
+        } else if (payload == "256") {
+            sweep<Queue, bench::Payload<256>>(config, queue_name, payload, single, results);
+        } else if (payload == "nontrivial") {
+            sweep<Queue, NonTrivialObj>(config, queue_name, payload, single, results);
+        } else {
+            std::cerr << "unknown payload: " << payload << std::endl;
+        }
+    }
+}
+
+static void write(const Config& config, const std::vector<Result>& results, std::ostream& out) {
+    if (config.format == "json") {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            auto& r = results[i];
+            out << "  {\"queue\": \"" << r.queue << "\", \"producers\": " << r.producers
+                << ", \"consumers\": " << r.consumers << ", \"capacity\": " << r.capacity << ", \"payload\": \""
+                << r.payload << "\", \"messages\": " << r.messages << ", \"msgs_per_sec\": " << std::fixed
+                << r.rate << "}" << (i + 1 == results.size() ? "\n" : ",\n");
+        }
+        out << "]" << std::endl;
+    } else {
+        out << "queue,producers,consumers,capacity,payload,messages,msgs_per_sec\n";
+        for (auto& r : results) {
+            out << r.queue << "," << r.producers << "," << r.consumers << "," << r.capacity << "," << r.payload
+                << "," << r.messages << "," << std::fixed << r.rate << "\n";
+        }
+        out.flush();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Config config = parse(argc, argv);
+
+    std::vector<Result> results;
+    for (auto& queue : config.queues) {
+        if (queue == "spsc") {
+            sweepPayloads<DefaultSpscQueue>(config, "SpscQueue", true, results);
+        } else if (queue == "unique") {
+            sweepPayloads<DefaultMpmcUniqueQueue>(config, "MpmcUniqueQueue", false, results);
+        } else if (queue == "shared") {
+            sweepPayloads<DefaultMpmcSharedQueue>(config, "MpmcSharedQueue", false, results);
+        } else if (queue == "sequence") {
+            sweepPayloads<MpmcSequenceQueue>(config, "MpmcSequenceQueue", false, results);
+        } else if (queue == "unbounded") {
+            sweepPayloads<UnboundedQueue>(config, "UnboundedQueue", false, results);
+        } else {
+            std::cerr << "unknown queue: " << queue << std::endl;
+        }
+    }
+
+    if (config.output.empty()) {
+        write(config, results, std::cout);
+    } else {
+        std::ofstream file(config.output);
+        write(config, results, file);
+    }
+    return 0;
+}
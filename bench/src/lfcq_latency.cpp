@@ -0,0 +1,192 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "bench.hpp"
+#include "histogram.hpp"
+#include "mpmc_sequence_queue.hpp"
+#include "mpmc_shared_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "tools.hpp"
+
+using namespace lfcq;
+
+/* options of the harness: */
+/*   --mode=pingpong,openloop   closed-loop round trips through two queues and/or a fixed-rate one-way stream */
+/*   --queues=spsc,unique,shared,sequence */
+/*   --messages=N               messages measured in each run, after the same amount of warmup */
+/*   --rate=N                   messages per second sent by the open-loop generator */
+/*   --capacity=N               capacity of every queue */
+/*   --pin=a,b                  CPUs of the two threads */
+/*   --dump=prefix              write the full distribution of each run to <prefix><queue>_<mode>.csv */
+struct Config {
+    std::vector<std::string> modes = {"pingpong", "openloop"};
+    std::vector<std::string> queues = {"spsc", "unique", "shared", "sequence"};
+    uint64_t messages = 1'000'000;
+    uint64_t rate = 1'000'000;
+    uint32_t capacity = 1024;
+    std::vector<int> cpus;
+    std::string dump;
+};
+
+/* what travels through the queues, the TSC timestamp the message is meant to be sent at. */
+struct Stamp {
+    uint64_t tsc;
+};
+
+static std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+static Config parse(int argc, char* argv[]) {
+    Config config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        std::string key = arg.substr(0, eq), value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--mode") {
+            config.modes = split(value);
+        } else if (key == "--queues") {
+            config.queues = split(value);
+        } else if (key == "--messages") {
+            config.messages = std::stoull(value);
+        } else if (key == "--rate") {
+            config.rate = std::stoull(value);
+        } else if (key == "--capacity") {
+            config.capacity = std::stoul(value);
+        } else if (key == "--pin") {
+            for (auto& cpu : split(value)) {
+                config.cpus.push_back(std::stoi(cpu));
+            }
+        } else if (key == "--dump") {
+            config.dump = value;
+        } else {
+            std::cerr << "unknown option: " << arg << std::endl;
+            std::exit(1);
+        }
+    }
+    return config;
+}
+
+static void pin(const Config& config, size_t which) {
+    if (config.cpus.size() > which) bench::pinThread(config.cpus[which]);
+}
+
+/* closed loop: the client sends its timestamp through <ping> and waits for the echo from <pong>. */
+/* the whole round trip is recorded, halve it for a rough one-way figure. */
+template <typename Queue>
+bench::Histogram pingPong(const Config& config, double tsc_per_ns) {
+    Queue ping(config.capacity), pong(config.capacity);
+    uint64_t total = config.messages * 2;
+
+    std::thread echo([&]() {
+        pin(config, 1);
+        for (uint64_t i = 0; i < total; i++) {
+            Stamp stamp;
+            while (!ping.pop([&stamp](Stamp& obj) { stamp = obj; })) {}
+            while (!pong.push(stamp)) {}
+        }
+    });
+
+    bench::Histogram histogram;
+    pin(config, 0);
+    for (uint64_t i = 0; i < total; i++) {
+        Stamp stamp{test::rdtscp()};
+        while (!ping.push(stamp)) {}
+        while (!pong.pop([&stamp](Stamp& obj) { stamp = obj; })) {}
+
+        // the first half only warms up caches and branch predictors
+        if (i >= config.messages) histogram.record((test::rdtscp() - stamp.tsc) / tsc_per_ns);
+    }
+
+    echo.join();
+    return histogram;
+}
+
+/* open loop: the generator sends at a fixed rate whatever the consumer does, and every latency is measured */
+/* from the moment the message was meant to be sent, so a stalled sender can't hide its stall (coordinated omission). */
+template <typename Queue>
+bench::Histogram openLoop(const Config& config, double tsc_per_ns) {
+    Queue queue(config.capacity);
+    uint64_t total = config.messages * 2;
+    double interval = 1e9 / config.rate * tsc_per_ns;
+
+    bench::Histogram histogram;
+    std::thread consumer([&]() {
+        pin(config, 1);
+        for (uint64_t i = 0; i < total; i++) {
+            Stamp stamp;
+            while (!queue.pop([&stamp](Stamp& obj) { stamp = obj; })) {}
+            uint64_t now = test::rdtscp();
+            if (i >= config.messages) histogram.record(now > stamp.tsc ? (now - stamp.tsc) / tsc_per_ns : 0);
+        }
+    });
+
+    pin(config, 0);
+    uint64_t beg = test::rdtscp();
+    for (uint64_t i = 0; i < total; i++) {
+        Stamp stamp{beg + static_cast<uint64_t>(i * interval)};
+        while (test::rdtscp() < stamp.tsc) {}
+        while (!queue.push(stamp)) {}
+    }
+
+    consumer.join();
+    return histogram;
+}
+
+static void report(const Config& config, const char* queue, const std::string& mode, const bench::Histogram& hist) {
+    std::printf("%-20s %-10s", queue, mode.c_str());
+    for (double p : {50.0, 90.0, 99.0, 99.9, 99.99}) {
+        std::printf(" p%-5g %8lu", p, hist.percentile(p));
+    }
+    std::printf(" max %10lu ns\n", hist.max());
+
+    if (!config.dump.empty()) {
+        std::ofstream file(config.dump + queue + "_" + mode + ".csv");
+        hist.dump(file);
+    }
+}
+
+template <typename Queue>
+void run(const Config& config, const char* queue, double tsc_per_ns) {
+    for (auto& mode : config.modes) {
+        if (mode == "pingpong") {
+            report(config, queue, mode, pingPong<Queue>(config, tsc_per_ns));
+        } else if (mode == "openloop") {
+            report(config, queue, mode, openLoop<Queue>(config, tsc_per_ns));
+        } else {
+            std::cerr << "unknown mode: " << mode << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Config config = parse(argc, argv);
+
+    double tsc_per_ns = bench::tscPerNs();
+    std::printf("TSC calibrated at %.3f ticks/ns, latencies in ns\n", tsc_per_ns);
+
+    for (auto& queue : config.queues) {
+        if (queue == "spsc") {
+            run<SpscQueue<Stamp>>(config, "SpscQueue", tsc_per_ns);
+        } else if (queue == "unique") {
+            run<MpmcUniqueQueue<Stamp>>(config, "MpmcUniqueQueue", tsc_per_ns);
+        } else if (queue == "shared") {
+            run<MpmcSharedQueue<Stamp>>(config, "MpmcSharedQueue", tsc_per_ns);
+        } else if (queue == "sequence") {
+            run<MpmcSequenceQueue<Stamp>>(config, "MpmcSequenceQueue", tsc_per_ns);
+        } else {
+            std::cerr << "unknown queue: " << queue << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "bench.hpp"
+#include "mpmc_sequence_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+static constexpr uint32_t capacity = 1024;
+
+/* every producer and consumer times its own successful operations, which are merged afterwards. */
+template <typename Queue>
+void measure(const char* name, uint32_t threads, uint64_t total) {
+    Queue queue(capacity);
+    std::vector<std::vector<uint64_t>> samples(threads);
+    std::atomic<uint32_t> slot = 0;
+
+    // worker threads are created for each measurement so the thread local storage starts empty
+    auto local = [&]() -> std::vector<uint64_t>& {
+        thread_local std::vector<uint64_t>* mine = nullptr;
+        if (mine == nullptr) {
+            mine = &samples[slot.fetch_add(1)];
+            mine->reserve(total / threads * 2);
+        }
+        return *mine;
+    };
+
+    auto now = []() { return std::chrono::steady_clock::now().time_since_epoch().count(); };
+    auto push = [&](uint64_t i) {
+        int64_t beg = now();
+        if (!queue.emplace(0U, static_cast<uint32_t>(i))) return false;
+        local().push_back(now() - beg);
+        return true;
+    };
+    auto pop = [&]() {
+        int64_t beg = now();
+        if (!queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj); })) return false;
+        local().push_back(now() - beg);
+        return true;
+    };
+    bench::throughput(threads / 2, threads / 2, total, push, pop);
+
+    std::vector<uint64_t> merged;
+    for (auto& sample : samples) {
+        merged.insert(merged.end(), sample.begin(), sample.end());
+    }
+    std::sort(merged.begin(), merged.end());
+
+    char item[32];
+    for (double p : {0.5, 0.99, 0.999}) {
+        std::snprintf(item, sizeof(item), "%u threads p%g", threads, p * 100);
+        bench::report(name, item, merged[static_cast<size_t>(p * (merged.size() - 1))], "ns");
+    }
+    std::snprintf(item, sizeof(item), "%u threads max", threads);
+    bench::report(name, item, merged.back(), "ns");
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+    uint32_t cores = std::max(2U, std::thread::hardware_concurrency());
+
+    for (uint32_t threads : {cores, cores * 2, cores * 4}) {
+        measure<MpmcUniqueQueue<TrivialObj>>("MpmcUniqueQueue", threads, total);
+        measure<MpmcSequenceQueue<TrivialObj>>("MpmcSequenceQueue", threads, total);
+    }
+    return 0;
+}
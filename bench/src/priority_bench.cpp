@@ -0,0 +1,99 @@
+#include <array>
+#include <cstdlib>
+#include <thread>
+
+#include "bench.hpp"
+#include "histogram.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "priority_queue.hpp"
+#include "tools.hpp"
+
+using namespace lfcq;
+
+static constexpr uint32_t levels = 3;
+static constexpr uint32_t capacity = 1024;
+
+/* what travels through the queues, the TSC timestamp it was pushed at and its priority. */
+struct Msg {
+    uint64_t tsc;
+    uint32_t level;
+};
+
+/* 1 in 64 messages is urgent, 1 in 8 is normal, and the rest is bulk traffic. */
+static uint32_t levelOf(uint64_t i) {
+    if (i % 64 == 0) return 0;
+    if (i % 8 == 0) return 1;
+    return 2;
+}
+
+/* <producers> threads keep the queue saturated while one consumer drains it. */
+/* return the push-to-pop latency of every level in ns. */
+template <typename Push, typename Pop>
+std::array<bench::Histogram, levels> mixed(uint32_t producers, uint64_t total, double tsc_per_ns, Push&& push,
+                                           Pop&& pop) {
+    std::vector<std::thread> workers;
+    for (uint32_t p = 0; p < producers; p++) {
+        workers.emplace_back([&, p]() {
+            for (uint64_t i = p; i < total; i += producers) {
+                Msg msg{0, levelOf(i)};
+                do {
+                    msg.tsc = test::rdtscp();
+                } while (!push(msg));
+            }
+        });
+    }
+
+    std::array<bench::Histogram, levels> hists;
+    for (uint64_t i = 0; i < total;) {
+        pop([&](Msg& msg) {
+            uint64_t now = test::rdtscp();
+            hists[msg.level].record(now > msg.tsc ? (now - msg.tsc) / tsc_per_ns : 0);
+            i++;
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return hists;
+}
+
+static void report(const char* queue, const std::array<bench::Histogram, levels>& hists) {
+    for (uint32_t l = 0; l < levels; l++) {
+        std::printf("%-24s level %u", queue, l);
+        for (double p : {50.0, 99.0, 99.9}) {
+            std::printf(" p%-5g %10lu", p, hists[l].percentile(p));
+        }
+        std::printf(" max %10lu ns\n", hists[l].max());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4'000'000;
+    uint32_t producers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2;
+
+    double tsc_per_ns = bench::tscPerNs();
+    std::printf("TSC calibrated at %.3f ticks/ns, latencies in ns\n", tsc_per_ns);
+
+    {
+        PriorityQueue<Msg, levels> queue(capacity);
+        auto push = [&](Msg msg) { return queue.push(msg.level, msg); };
+        auto pop = [&](auto&& handle) { queue.pop(handle); };
+        report("PriorityQueue", mixed(producers, total, tsc_per_ns, push, pop));
+    }
+    {
+        PriorityQueue<Msg, levels> queue(capacity);
+        Fairness fairness{8, 1};
+        auto push = [&](Msg msg) { return queue.push(msg.level, msg); };
+        auto pop = [&](auto&& handle) { queue.pop(handle, fairness); };
+        report("PriorityQueue fair 8:1", mixed(producers, total, tsc_per_ns, push, pop));
+    }
+    {
+        // every level shares one ring, so urgent messages queue up behind bulk traffic
+        MpmcUniqueQueue<Msg> queue(capacity * levels);
+        auto push = [&](Msg msg) { return queue.push(msg); };
+        auto pop = [&](auto&& handle) { queue.pop(handle); };
+        report("MpmcUniqueQueue FIFO", mixed(producers, total, tsc_per_ns, push, pop));
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <cstdlib>
+#include <thread>
+
+#include "bench.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "sharded_queue.hpp"
+#include "spsc_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+static constexpr uint32_t capacity = 1024;
+
+/* run <producers> and <consumers> on a queue pushed through <push>(producer, obj), return million msgs/s. */
+template <typename Queue, typename Push>
+double scale(Queue& queue, uint32_t producers, uint32_t consumers, uint64_t total, Push&& push) {
+    // <throughput> hands producer p the messages [p * per_producer, (p + 1) * per_producer)
+    uint64_t per_producer = total / producers;
+    auto produce = [&](uint64_t i) {
+        uint32_t producer = static_cast<uint32_t>(i / per_producer);
+        return push(producer, TrivialObj{producer, static_cast<uint32_t>(i)});
+    };
+    auto consume = [&]() { return queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj.seq); }); };
+    return bench::throughput(producers, consumers, total, produce, consume) / 1e6;
+}
+
+/* one <SpscQueue> shard per producer, the single consumer fans in round-robin. */
+double shardedSpsc(uint32_t producers, uint64_t total) {
+    ShardedQueue<TrivialObj, SpscQueue<TrivialObj>> queue(producers, capacity);
+    return scale(queue, producers, 1, total, [&](uint32_t p, TrivialObj obj) { return queue.push(p, obj); });
+}
+
+/* one small MPMC shard per producer, consumers pick the fuller of two random shards. */
+double shardedMpmc(uint32_t producers, uint32_t consumers, uint64_t total) {
+    ShardedQueue<TrivialObj, MpmcUniqueQueue<TrivialObj>, Selection::TwoChoices> queue(producers, capacity);
+    return scale(queue, producers, consumers, total, [&](uint32_t p, TrivialObj obj) { return queue.push(p, obj); });
+}
+
+/* every producer contends on the indices of one ring of the same total capacity. */
+double single(uint32_t producers, uint32_t consumers, uint64_t total) {
+    MpmcUniqueQueue<TrivialObj> queue(capacity * producers);
+    return scale(queue, producers, consumers, total, [&](uint32_t, TrivialObj obj) { return queue.push(obj); });
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20'000'000;
+    uint32_t cores = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::max(2U, std::thread::hardware_concurrency());
+
+    // producers double up to all the cores but one, which is left to the consumer
+    std::vector<uint32_t> counts;
+    for (uint32_t p = 1; p < cores - 1; p *= 2) {
+        counts.push_back(p);
+    }
+    counts.push_back(cores - 1);
+
+    char item[48];  // room for two counts of 10 digits
+    for (uint32_t p : counts) {
+        std::snprintf(item, sizeof(item), "%u producers x 1", p);
+        bench::report("Sharded SpscQueue", item, shardedSpsc(p, total), "M msgs/s");
+        bench::report("Sharded MpmcUnique", item, shardedMpmc(p, 1, total), "M msgs/s");
+        bench::report("MpmcUniqueQueue", item, single(p, 1, total), "M msgs/s");
+    }
+    for (uint32_t p : counts) {
+        // a single consumer has been measured above
+        uint32_t c = p / 2;
+        if (c < 2) continue;
+
+        std::snprintf(item, sizeof(item), "%u producers x %u", p, c);
+        bench::report("Sharded MpmcUnique", item, shardedMpmc(p, c, total), "M msgs/s");
+        bench::report("MpmcUniqueQueue", item, single(p, c, total), "M msgs/s");
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "bench.hpp"
+#include "payload.hpp"
+#include "shm_mpmc_unique_queue.hpp"
+#include "shm_spsc_queue.hpp"
+
+using namespace lfcq;
+
+using Message = bench::Payload<64>;
+
+static constexpr uint32_t capacity = 4096;
+
+/* run <consumer> in a child process and <producer> here, return the throughput in messages per second. */
+/* the clock starts once the child is ready and stops once it has received everything and exited. */
+template <typename Producer, typename Consumer>
+double twoProcesses(uint64_t total, Producer&& producer, Consumer&& consumer) {
+    int ready[2];
+    if (pipe(ready) != 0) std::exit(1);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(ready[0]);
+        consumer(total, ready[1]);
+        _exit(0);
+    }
+
+    close(ready[1]);
+    char byte;
+    if (read(ready[0], &byte, 1) != 1) std::exit(1);
+    close(ready[0]);
+
+    auto beg = std::chrono::steady_clock::now();
+    producer(total);
+    waitpid(pid, nullptr, 0);
+    auto end = std::chrono::steady_clock::now();
+    return total / std::chrono::duration<double>(end - beg).count();
+}
+
+static void announce(int fd) {
+    if (write(fd, "", 1) != 1) _exit(1);
+    close(fd);
+}
+
+/* both sides attach to the queue by name, as unrelated processes would. */
+template <typename Queue>
+double shm(uint64_t total) {
+    std::string name = "/lfcq_bench_" + std::to_string(getpid());
+    auto queue = Queue::create(name, capacity);
+
+    return twoProcesses(
+        total,
+        [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                while (!queue.push(Message{0, static_cast<uint32_t>(i), {}})) {}
+            }
+        },
+        [&](uint64_t n, int fd) {
+            auto consumer = Queue::attach(name);
+            announce(fd);
+            for (uint64_t i = 0; i < n; i++) {
+                while (!consumer.pop([](Message& obj) { bench::doNotOptimize(obj.seq); })) {}
+            }
+        });
+}
+
+/* the same messages copied through a unix socket pair, one syscall on each side per message. */
+static double socketPair(uint64_t total) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) != 0) std::exit(1);
+
+    double rate = twoProcesses(
+        total,
+        [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                Message msg{0, static_cast<uint32_t>(i), {}};
+                if (write(fds[0], &msg, sizeof(msg)) != sizeof(msg)) std::exit(1);
+            }
+        },
+        [&](uint64_t n, int fd) {
+            announce(fd);
+            for (uint64_t i = 0; i < n; i++) {
+                Message msg;
+                if (read(fds[1], &msg, sizeof(msg)) != sizeof(msg)) _exit(1);
+                bench::doNotOptimize(msg.seq);
+            }
+        });
+
+    close(fds[0]);
+    close(fds[1]);
+    return rate;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16'000'000;
+
+    bench::report("ShmSpscQueue", "64B, 2 processes", 1e9 / shm<ShmSpscQueue<Message>>(total), "ns/msg");
+    bench::report("ShmMpmcUniqueQueue", "64B, 2 processes", 1e9 / shm<ShmMpmcUniqueQueue<Message>>(total), "ns/msg");
+    bench::report("socketpair", "64B, 2 processes", 1e9 / socketPair(total / 16), "ns/msg");
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <cstdlib>
+#include <memory>
+
+#include "bench.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "static_queue.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+static constexpr uint32_t capacity = 1024;
+
+/* a single thread pushes an element and pops it back, return ns per pair, which is mostly index arithmetic. */
+template <typename Queue>
+double pingSelf(Queue& queue, uint64_t total) {
+    return bench::nsPerOp(total, [&](uint64_t i) {
+        queue.push(TrivialObj{0, static_cast<uint32_t>(i)});
+        queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj); });
+    });
+}
+
+/* one producer and one consumer pass <total> messages, return million msgs/s. */
+template <typename Queue>
+double transfer(Queue& queue, uint64_t total) {
+    auto push = [&](uint64_t i) { return queue.push(TrivialObj{0, static_cast<uint32_t>(i)}); };
+    auto pop = [&]() { return queue.pop([](TrivialObj& obj) { bench::doNotOptimize(obj); }); };
+    return bench::throughput(1, 1, total, push, pop) / 1e6;
+}
+
+/* report both measures of a queue built by <make>. */
+template <typename Make>
+void measure(const char* name, const char* item, uint64_t total, Make&& make) {
+    auto queue = make();
+    char label[48];
+    std::snprintf(label, sizeof(label), "%s same thread", item);
+    bench::report(name, label, pingSelf(*queue, total), "ns/op");
+    std::snprintf(label, sizeof(label), "%s 1 x 1", item);
+    bench::report(name, label, transfer(*queue, total / 4), "M msgs/s");
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000'000;
+
+    measure("SpscQueue", "runtime", total, []() { return std::make_unique<SpscQueue<TrivialObj>>(capacity); });
+    measure("StaticSpscQueue", "16-bit", total,
+            []() { return std::make_unique<StaticSpscQueue<TrivialObj, capacity, uint16_t>>(); });
+    measure("StaticSpscQueue", "32-bit", total,
+            []() { return std::make_unique<StaticSpscQueue<TrivialObj, capacity, uint32_t>>(); });
+    measure("StaticSpscQueue", "64-bit", total,
+            []() { return std::make_unique<StaticSpscQueue<TrivialObj, capacity, uint64_t>>(); });
+
+    measure("MpmcUniqueQueue", "runtime", total,
+            []() { return std::make_unique<MpmcUniqueQueue<TrivialObj>>(capacity); });
+    measure("StaticMpmcQueue", "32-bit", total,
+            []() { return std::make_unique<StaticMpmcQueue<TrivialObj, capacity, uint32_t>>(); });
+    measure("StaticMpmcQueue", "64-bit", total,
+            []() { return std::make_unique<StaticMpmcQueue<TrivialObj, capacity, uint64_t>>(); });
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include "bench.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "work_stealing_deque.hpp"
+
+using namespace lfcq;
+
+/* a fork-join tree: a task of <depth> above 0 forks two tasks of <depth> - 1, leaves only spin a little. */
+struct Task {
+    uint32_t depth;
+};
+
+static void leaf() {
+    for (uint32_t i = 0; i < 32; i++) {
+        bench::doNotOptimize(i);
+    }
+}
+
+/* run the tree of <depth> on <workers> threads, return ns per task. */
+/* <run>(w, done) is the loop of worker <w>, which adds how many tasks it has executed to <done>. */
+template <typename Run>
+double forkJoin(uint32_t workers, uint32_t depth, Run&& run) {
+    uint64_t total = (2ULL << depth) - 1;
+    std::atomic<uint64_t> done = 0;
+
+    auto beg = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t w = 0; w < workers; w++) {
+        threads.emplace_back([&, w]() { run(w, total, done); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - beg).count() / total;
+}
+
+/* execute <task>, handing its children to <fork>. */
+template <typename Fork>
+static void execute(const Task& task, Fork&& fork) {
+    if (task.depth == 0) {
+        leaf();
+        return;
+    }
+    fork(Task{task.depth - 1});
+    fork(Task{task.depth - 1});
+}
+
+/* every worker owns a deque, forks to its bottom and steals from random victims when it runs dry. */
+double stealing(uint32_t workers, uint32_t depth) {
+    std::vector<std::unique_ptr<WorkStealingDeque<Task>>> deques;
+    for (uint32_t w = 0; w < workers; w++) {
+        deques.push_back(std::make_unique<WorkStealingDeque<Task>>(256));
+    }
+    deques[0]->push(Task{depth});
+
+    return forkJoin(workers, depth, [&](uint32_t w, uint64_t total, std::atomic<uint64_t>& done) {
+        WorkStealingDeque<Task>& own = *deques[w];
+        auto fork = [&](Task task) { own.push(task); };
+
+        uint64_t executed = 0;
+        auto handle = [&](Task& task) {
+            execute(task, fork);
+            executed++;
+        };
+
+        // a private xorshift picks victims, so thieves share nothing but the deques
+        uint32_t seed = w * 2654435761U + 1;
+        while (true) {
+            if (own.pop(handle)) continue;
+
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            if (workers > 1 && deques[seed % workers]->steal(handle)) continue;
+
+            // out of work, publish what was done and see whether anything is left at all
+            done += std::exchange(executed, 0);
+            if (done == total) return;
+            std::this_thread::yield();
+        }
+    });
+}
+
+/* every worker forks to and takes from one shared MPMC queue. */
+double pool(uint32_t workers, uint32_t depth) {
+    MpmcUniqueQueue<Task> queue(2U << depth);
+    queue.push(Task{depth});
+
+    return forkJoin(workers, depth, [&](uint32_t, uint64_t total, std::atomic<uint64_t>& done) {
+        auto fork = [&](Task task) { queue.push(task); };
+
+        uint64_t executed = 0;
+        auto handle = [&](Task& task) {
+            execute(task, fork);
+            executed++;
+        };
+        while (true) {
+            if (queue.pop(handle)) continue;
+
+            done += std::exchange(executed, 0);
+            if (done == total) return;
+            std::this_thread::yield();
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20;
+
+    char item[32];
+    for (uint32_t workers : {1, 2, 4}) {
+        std::snprintf(item, sizeof(item), "%u workers", workers);
+        bench::report("WorkStealingDeque", item, stealing(workers, depth), "ns/task");
+        bench::report("MpmcUniqueQueue pool", item, pool(workers, depth), "ns/task");
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <optional>
+#include <thread>
+#include <utility>
+#include "wait.hpp"
+
+namespace lfcq {
+
+/* where a coroutine woken by the opposite side of a queue goes on running. */
+/* NOTE: <schedule> is called on the thread whose push or pop made room or data, so it must be thread-safe. */
+template <typename S>
+concept Scheduler = requires(S& scheduler, std::coroutine_handle<> handle) {
+    { scheduler.schedule(handle) } noexcept;
+};
+
+/* resume the coroutine right away on the notifying thread, within the push or pop that woke it. */
+struct InlineScheduler {
+    void schedule(std::coroutine_handle<> handle) noexcept { handle.resume(); }
+};
+
+// the scheduler of the awaitables given none
+inline InlineScheduler inline_scheduler;
+
+/* base of the awaitables of queue operations, <Derived> provides the operation itself as <attempt> and a check */
+/* whether it is likely to succeed as <ready>. */
+/* the operation completes without suspending if it succeeds at once, otherwise the coroutine is linked into */
+/* <parking_> of the queue, and the opposite side retries the operation on its behalf when it notifies, then */
+/* hands the coroutine to <scheduler_>, or links it again if others got there first. */
+/* NOTE: neither copyable nor movable, the node must stay in place while linked. */
+template <typename Derived, typename Queue, Scheduler S>
+class BasicAwaitable : private AwaitNode {
+  protected:
+    Queue& queue_;
+    Parking& parking_;
+    S& scheduler_;
+    std::coroutine_handle<> handle_;
+
+    BasicAwaitable(Queue& queue, Parking& parking, S& scheduler) noexcept
+        : AwaitNode{nullptr, &BasicAwaitable::wake}, queue_(queue), parking_(parking), scheduler_(scheduler) {}
+
+    /* link <self> until the operation is likely to succeed. */
+    /* return false if <self> has completed the operation meanwhile, true if it is left to a notifier. */
+    static bool park(BasicAwaitable* self) noexcept {
+        // once linked, <self> may be woken and destructed by a notifier, so only these copies are safe to touch
+        Queue& queue = self->queue_;
+        Parking& parking = self->parking_;
+
+        while (true) {
+            parking.enlist(self);
+            // either we see the change of the opposite side, or it sees us linked
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!Derived::ready(queue)) return true;
+
+            // take back the whole list, waking the others, unless a notifier has taken us already
+            if (!parking.wake_awaiters(self)) return true;
+            if (static_cast<Derived*>(self)->attempt()) return false;
+
+            // it looked ready, but others in the middle of an operation still hold the places
+            std::this_thread::yield();
+        }
+    }
+
+    /* called by the notifier which unlinked <node>. */
+    static void wake(AwaitNode* node) noexcept {
+        auto* self = static_cast<BasicAwaitable*>(node);
+        if (static_cast<Derived*>(self)->attempt() || !park(self)) self->scheduler_.schedule(self->handle_);
+    }
+
+  public:
+    BasicAwaitable(const BasicAwaitable& other) = delete;
+    BasicAwaitable& operator=(const BasicAwaitable& other) = delete;
+
+    /* complete right away if the operation succeeds now. */
+    bool await_ready() noexcept { return static_cast<Derived*>(this)->attempt(); }
+
+    /* suspend the coroutine <handle> until a notifier completes the operation. */
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        handle_ = handle;
+        return park(this);
+    }
+};
+
+/* awaitable popping an object of T from <Queue>, co_await it for the object. */
+template <typename T, typename Queue, Scheduler S = InlineScheduler>
+class PopAwaitable : public BasicAwaitable<PopAwaitable<T, Queue, S>, Queue, S> {
+    friend class BasicAwaitable<PopAwaitable, Queue, S>;
+
+  private:
+    std::optional<T> value_;
+
+    bool attempt() noexcept {
+        return this->queue_.pop([this](T& obj) { value_.emplace(std::move(obj)); });
+    }
+
+    static bool ready(Queue& queue) noexcept { return queue.size() != 0; }
+
+  public:
+    PopAwaitable(Queue& queue, Parking& parking, S& scheduler) noexcept
+        : BasicAwaitable<PopAwaitable, Queue, S>(queue, parking, scheduler) {}
+
+    T await_resume() noexcept { return std::move(*value_); }
+};
+
+/* awaitable pushing an object of T to <Queue>, which keeps the object until it is pushed. */
+template <typename T, typename Queue, Scheduler S = InlineScheduler>
+class PushAwaitable : public BasicAwaitable<PushAwaitable<T, Queue, S>, Queue, S> {
+    friend class BasicAwaitable<PushAwaitable, Queue, S>;
+
+  private:
+    T value_;
+
+    // a failed push leaves the object as it was
+    bool attempt() noexcept { return this->queue_.push(std::move(value_)); }
+
+    // places claimed by other pushes in the middle of them are not free yet, though not counted by <size>
+    static bool ready(Queue& queue) noexcept { return queue.room() != 0; }
+
+  public:
+    template <typename U>
+    PushAwaitable(Queue& queue, Parking& parking, S& scheduler, U&& obj) noexcept
+        : BasicAwaitable<PushAwaitable, Queue, S>(queue, parking, scheduler), value_(std::forward<U>(obj)) {}
+
+    void await_resume() noexcept {}
+};
+
+}  // namespace lfcq
@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <thread>
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* policy of how a thread waits before it retries a failed CAS or checks again an index it spins on. */
+/* an object is created for every wait and called after every failed iteration, so it may keep a delay. */
+template <typename B>
+concept BackoffPolicy = std::default_initializable<B> && std::invocable<B&>;
+
+/* retry at once, for threads which own their cores without a busy hyperthread sibling. */
+struct NoBackoff {
+    void operator()() noexcept {}
+};
+
+/* one pause per iteration, which leaves the pipeline to the sibling hyperthread and saves the machine clear */
+/* of a mis-speculated memory order when the loop exits. */
+struct PauseBackoff {
+    void operator()() noexcept { cpuRelax(); }
+};
+
+/* pauses doubling every iteration up to <Cap> of them, which spreads contending threads apart in time. */
+template <uint32_t Cap = 64>
+class ExponentialBackoff {
+  private:
+    uint32_t pauses_ = 1;
+
+  public:
+    void operator()() noexcept {
+        for (uint32_t i = 0; i < pauses_; i++) {
+            cpuRelax();
+        }
+        pauses_ = std::min(pauses_ * 2, Cap);
+    }
+};
+
+/* pause for the first <Spins> iterations and yield the CPU afterwards, so that with more threads than cores */
+/* the thread we are waiting for gets scheduled. */
+template <uint32_t Spins = 16>
+class YieldBackoff {
+  private:
+    uint32_t spins_ = 0;
+
+  public:
+    void operator()() noexcept {
+        if (spins_ < Spins) {
+            spins_++;
+            cpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+};
+
+}  // namespace lfcq
@@ -1,21 +1,56 @@
 #pragma once
+#include <algorithm>
+#include <concepts>
 #include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include "stats.hpp"
 #include "utils.hpp"
 
 namespace lfcq {
 
+/* start the lifetime of the element in <slot> from <args>. */
+template <typename T, typename... Args>
+inline void constructSlot(T& slot, Args&&... args) {
+    std::construct_at(std::addressof(slot), std::forward<Args>(args)...);
+}
+
+/* start the lifetime of the element in <slot> so that a handle can assign to it, free for trivial types. */
+/* types without a default constructor must be trivially copyable, whose raw storage can be assigned directly. */
+template <typename T>
+inline void initializeSlot(T& slot) {
+    if constexpr (std::default_initializable<T>) {
+        if constexpr (!std::is_trivially_default_constructible_v<T>) ::new (static_cast<void*>(std::addressof(slot))) T;
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "handles only fill default constructible or trivial elements");
+    }
+}
+
+/* end the lifetime of the element in <slot>, free for trivially destructible types. */
+template <typename T>
+inline void destroySlot(T& slot) {
+    if constexpr (!std::is_trivially_destructible_v<T>) std::destroy_at(std::addressof(slot));
+}
+
 /* base class for all types of lock-free circular queues. */
 /* NOTE: available for moving but not for copying. */
 /* NOTE: all callbacks provided by user are forbidden to throw exception. */
 /* NOTE: user can customize the memory allocator for the queue. */
-template <typename T, typename Allocator>
+/* NOTE: fields here are read-only after construction, derived queues must place their */
+/* indices on separate cache lines so that writing to them never invalidates these fields. */
+/* NOTE: user can collect statistics by a policy like <ShardedStats>, which costs nothing by default. */
+/* NOTE: storage is allocated raw, derived queues construct an element on push and destroy it on pop, */
+/* or keep every slot constructed by <construct_all> if elements are read in place by several consumers. */
+template <typename T, typename Allocator, typename Stats = NoStats>
 class BasicQueue {
   protected:
     Allocator alloc_;
     uint32_t size_;
     uint32_t mask_;
     T* queue_;
+    [[no_unique_address]] Stats stats_;
 
   public:
     BasicQueue(uint32_t size, const Allocator& alloc) : alloc_(alloc) {
@@ -33,7 +68,7 @@ class BasicQueue {
     BasicQueue(const BasicQueue& other) = delete;
     BasicQueue& operator=(const BasicQueue& other) = delete;
 
-    BasicQueue(BasicQueue&& other) noexcept : alloc_(std::move(other.alloc_)) {
+    BasicQueue(BasicQueue&& other) noexcept : alloc_(std::move(other.alloc_)), stats_(std::move(other.stats_)) {
         size_ = other.size_;
         mask_ = other.mask_;
 
@@ -41,25 +76,62 @@ class BasicQueue {
     }
 
     BasicQueue& operator=(BasicQueue&& other) noexcept {
-        if (this != other) {
+        if (this != &other) {
+            // derived queues have destroyed their elements already
+            if (queue_) alloc_.deallocate(queue_, size_);
+
             size_ = other.size_;
             mask_ = other.mask_;
 
             alloc_ = std::move(other.alloc_);
+            stats_ = std::move(other.stats_);
             queue_ = std::exchange(other.queue_, nullptr);
         }
         return *this;
     }
 
-#ifndef NDEBUG
-    /* dump the content of the queue on range [beg, end). */
-    void dump(uint32_t beg, uint32_t end, std::string&& path) {
-        Dumper dumper(std::move(path));
-        for (uint32_t i = beg; i != end; i++) {
-            dumper.dump(i & mask_, ": {", queue_[i & mask_], "}");
+  protected:
+    /* default construct every slot, for queues that assign to live slots rather than construct on push. */
+    void construct_all() {
+        for (uint32_t i = 0; i < size_; i++) {
+            initializeSlot(queue_[i]);
+        }
+    }
+
+    /* destroy every slot constructed by <construct_all>. */
+    void destroy_all() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            if (queue_ == nullptr) return;
+            for (uint32_t i = 0; i < size_; i++) {
+                destroySlot(queue_[i]);
+            }
         }
     }
-#endif
+
+    /* copy <n> elements from <src> into the places from index <idx>, which may wrap around the end of the ring. */
+    template <CopyMode Mode = CopyMode::Regular>
+    void copy_in(uint32_t idx, const T* src, uint32_t n) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        uint32_t beg = idx & mask_, first = std::min(n, size_ - beg);
+        copyBytes<Mode>(queue_ + beg, src, first * sizeof(T));
+        copyBytes<Mode>(queue_, src + first, (n - first) * sizeof(T));
+        if constexpr (Mode == CopyMode::Streaming) storeFence();
+    }
+
+    /* copy <n> elements from the places from index <idx> out to <dst>, which may wrap around the end of the ring. */
+    void copy_out(uint32_t idx, T* dst, uint32_t n) const noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        uint32_t beg = idx & mask_, first = std::min(n, size_ - beg);
+        copyBytes<CopyMode::Regular>(dst, queue_ + beg, first * sizeof(T));
+        copyBytes<CopyMode::Regular>(dst + first, queue_, (n - first) * sizeof(T));
+    }
+
+  public:
+    /* how many elements the queue holds at most. */
+    uint32_t capacity() const noexcept { return size_; }
+
+    /* take a snapshot of the statistics, all zero unless a statistics policy is enabled. */
+    QueueStats stats() const noexcept { return stats_.snapshot(); }
 };
 
 }  // namespace lfcq
\ No newline at end of file
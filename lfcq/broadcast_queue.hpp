@@ -0,0 +1,231 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "backoff.hpp"
+#include "basic_queue.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* multiple producer broadcast lock-free circular queue, in the style of the LMAX Disruptor. */
+/* EVERY subscribed consumer reads every element through its own cursor, and producers are gated by the slowest. */
+/* a consumer may subscribe behind other consumers, then it only reads the elements all of them have finished. */
+/* NOTE: available for moving but not for copying. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: user can customize the memory allocator for the queue. */
+/* NOTE: each consumer must be driven by one thread at a time, and elements are read-only to consumers. */
+/* NOTE: <subscribe> must not be called concurrently with itself, subscribe before publishing to see everything. */
+/* NOTE: every slot stays constructed for the lifetime of the queue and pushes assign to it, */
+/* T must be default constructible or trivially copyable. */
+/* NOTE: producers retrying a failed CAS or waiting for earlier commits back off according to <Backoff>. */
+template <typename T, typename Allocator = std::allocator<T>, BackoffPolicy Backoff = PauseBackoff>
+class BroadcastQueue : public BasicQueue<T, Allocator> {
+  private:
+    struct alignas(CACHELINE_SIZE) Consumer {
+        std::atomic<uint32_t> done;  // elements before it have been read by this consumer
+        uint32_t avail = 0;          // how far the barrier was when last checked
+        std::vector<uint32_t> deps;  // consumers it reads behind, the producers if none
+    };
+
+    // each index lives on its own cache line so producers and consumers never share one
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_w_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_w_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> gate_;  // the slowest cursor producers have seen
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> subscribed_;
+    uint32_t max_consumers_;
+    std::unique_ptr<Consumer[]> consumers_;
+
+    /* return the slowest of all cursors, or <idx_w> if nobody subscribed. */
+    uint32_t slowest(uint32_t idx_w) noexcept {
+        // <idx_w> may be stale already, so a cursor can be ahead of it
+        int32_t lag = 0;
+        uint32_t cnt = subscribed_.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < cnt; i++) {
+            lag = std::max(lag, static_cast<int32_t>(idx_w - consumers_[i].done.load(std::memory_order_acquire)));
+        }
+        return idx_w - lag;
+    }
+
+    /* return how far consumer <c> at <head> may read, i.e. the slowest of what it depends on. */
+    uint32_t barrier(const Consumer& c, uint32_t head) noexcept {
+        if (c.deps.empty()) return done_w_.load(std::memory_order_acquire);
+
+        uint32_t avail = UINT32_MAX;
+        for (uint32_t dep : c.deps) {
+            avail = std::min(avail, consumers_[dep].done.load(std::memory_order_acquire) - head);
+        }
+        return head + avail;
+    }
+
+    /* try to acquire at most <n> places for writing, which start from <idx_w> on return. */
+    /* return how many places are acquired, 0 if the slowest consumer is a whole queue behind. */
+    uint32_t acquire_w(uint32_t& idx_w, uint32_t n) noexcept {
+        idx_w = next_w_.load(std::memory_order_acquire);
+        for (Backoff backoff;; backoff()) {
+            // the cached gate only lags behind the real one, so it is reloaded only when it looks short
+            uint32_t used = idx_w - gate_.load(std::memory_order_acquire);
+            if (used > this->size_ - n) {
+                uint32_t gate = slowest(idx_w);
+                gate_.store(gate, std::memory_order_release);
+                used = idx_w - gate;
+            }
+
+            n = std::min(n, this->size_ - used);
+            if (n == 0) return 0;
+            if (next_w_.compare_exchange_weak(idx_w, idx_w + n)) return n;
+        }
+    }
+
+    /* mark the <n> places starting from <idx_w> have done after all the earlier writes. */
+    void commit_w(uint32_t idx_w, uint32_t n) noexcept {
+        for (Backoff backoff; done_w_.load(std::memory_order_acquire) != idx_w; backoff()) {}
+        done_w_.store(idx_w + n, std::memory_order_release);
+    }
+
+  public:
+    /* construct a queue of at least <size> elements for at most <max_consumers> subscribers. */
+    BroadcastQueue(uint32_t size, uint32_t max_consumers, const Allocator& alloc = Allocator())
+        : BasicQueue<T, Allocator>(size, alloc),
+          next_w_(0),
+          done_w_(0),
+          gate_(0),
+          subscribed_(0),
+          max_consumers_(max_consumers),
+          consumers_(std::make_unique<Consumer[]>(max_consumers)) {
+        this->construct_all();
+    }
+
+    ~BroadcastQueue() { this->destroy_all(); }
+
+    BroadcastQueue(const BroadcastQueue& other) = delete;
+    BroadcastQueue& operator=(const BroadcastQueue& other) = delete;
+
+    BroadcastQueue(BroadcastQueue&& other) noexcept
+        : BasicQueue<T, Allocator>(std::move(other)),
+          next_w_(other.next_w_.load()),
+          done_w_(other.done_w_.load()),
+          gate_(other.gate_.load()),
+          subscribed_(other.subscribed_.load()),
+          max_consumers_(other.max_consumers_),
+          consumers_(std::move(other.consumers_)) {}
+
+    BroadcastQueue& operator=(BroadcastQueue&& other) noexcept {
+        if (this != &other) {
+            this->destroy_all();
+
+            next_w_ = other.next_w_.load();
+            done_w_ = other.done_w_.load();
+            gate_ = other.gate_.load();
+            subscribed_ = other.subscribed_.load();
+            max_consumers_ = other.max_consumers_;
+            consumers_ = std::move(other.consumers_);
+
+            BasicQueue<T, Allocator>::operator=(std::move(other));
+        }
+        return *this;
+    }
+
+    /* register a consumer reading behind the consumers in <deps>, or right behind the producers if none. */
+    /* it starts from the first element not yet read by all of <deps>, or from the next element published. */
+    /* return the id of the consumer to read with, throw if <max_consumers> are already subscribed. */
+    uint32_t subscribe(std::initializer_list<uint32_t> deps = {}) {
+        uint32_t id = subscribed_.load(std::memory_order_relaxed);
+        if (id == max_consumers_) throw std::length_error("too many consumers of broadcast queue");
+
+        for (uint32_t dep : deps) {
+            if (dep >= id) throw std::out_of_range("unknown consumer of broadcast queue");
+        }
+
+        Consumer& c = consumers_[id];
+        c.deps.assign(deps);
+
+        // start from the slowest of what it depends on
+        uint32_t head = done_w_.load(std::memory_order_acquire);
+        for (uint32_t dep : c.deps) {
+            uint32_t done = consumers_[dep].done.load(std::memory_order_acquire);
+            if (static_cast<int32_t>(done - head) < 0) head = done;
+        }
+        c.done.store(head, std::memory_order_relaxed);
+        c.avail = head;
+
+        // the new cursor takes part in gating the producers from now on
+        subscribed_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    /* push an object to the end of the queue. */
+    /* return false if the slowest consumer is a whole queue behind, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) noexcept requires RelatedTo<U, T> {
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
+
+        this->queue_[idx_w & this->mask_] = std::forward<U>(obj);
+
+        commit_w(idx_w, 1);
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the slowest consumer is a whole queue behind, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
+
+        handle(this->queue_[idx_w & this->mask_]);
+
+        commit_w(idx_w, 1);
+        return true;
+    }
+
+    /* push objects in range [first, last) to the end of the queue as a whole. */
+    /* return how many objects from <first> were pushed, fewer than requested if consumers lag behind. */
+    template <std::forward_iterator It>
+    uint32_t push_bulk(It first, It last) noexcept requires std::assignable_from<T&, std::iter_reference_t<It>> {
+        uint32_t n = static_cast<uint32_t>(std::min<size_t>(std::distance(first, last), this->size_));
+
+        uint32_t idx_w, cnt = acquire_w(idx_w, n);
+        for (uint32_t i = 0; i < cnt; i++, ++first) {
+            this->queue_[(idx_w + i) & this->mask_] = *first;
+        }
+
+        if (cnt != 0) commit_w(idx_w, cnt);
+        return cnt;
+    }
+
+    /* read at most <max> elements following the cursor of <consumer>, handling them in order with the callback. */
+    /* everything available is read in one batch, and the cursor only moves once afterwards. */
+    /* return how many elements were read, 0 if there is nothing new for the consumer now. */
+    template <typename F>
+    uint32_t pop_bulk(uint32_t consumer, F&& handle, uint32_t max) noexcept requires std::invocable<F, const T&> {
+        Consumer& c = consumers_[consumer];
+        uint32_t head = c.done.load(std::memory_order_relaxed);
+
+        // the barrier is only checked again after everything seen last time has been read
+        if (c.avail == head) c.avail = barrier(c, head);
+        uint32_t cnt = std::min(max, c.avail - head);
+
+        for (uint32_t i = 0; i < cnt; i++) {
+            handle(static_cast<const T&>(this->queue_[(head + i) & this->mask_]));
+        }
+
+        if (cnt != 0) c.done.store(head + cnt, std::memory_order_release);
+        return cnt;
+    }
+
+    /* read the element following the cursor of <consumer> and handle it with the callback. */
+    /* return false if there is nothing new for the consumer now, otherwise true. */
+    template <typename F>
+    bool pop(uint32_t consumer, F&& handle) noexcept requires std::invocable<F, const T&> {
+        return pop_bulk(consumer, std::forward<F>(handle), 1) != 0;
+    }
+};
+
+}  // namespace lfcq
@@ -0,0 +1,291 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include "basic_queue.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* base class for lock-free rings of variable-length messages, stored as length-prefixed records. */
+/* every record is an 8-byte header followed by the message, and takes a multiple of 8 bytes so the messages */
+/* stay 8-byte aligned. a record never wraps: the space left at the end of the ring is filled by a padding */
+/* record, which readers skip, and the record goes to the beginning instead. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: the capacity counts bytes, and a message takes at most <max_message> of them. */
+template <typename Allocator, typename Stats>
+class BasicByteQueue : public BasicQueue<std::byte, Allocator, Stats> {
+  protected:
+    struct Header {
+        uint32_t size;    // bytes of the whole record including the header, 0 if not yet committed
+        uint32_t length;  // bytes of the message, or <PADDING> for a padding record
+    };
+    static constexpr uint32_t HEADER_SIZE = sizeof(Header);
+    static constexpr uint32_t PADDING = UINT32_MAX;
+
+    Header* header(uint32_t idx) const noexcept {
+        return reinterpret_cast<Header*>(this->queue_ + (idx & this->mask_));
+    }
+
+    /* bytes taken by the record of a <n>-byte message. */
+    static uint32_t record_size(uint32_t n) noexcept { return (HEADER_SIZE + n + 7) & ~7U; }
+
+    /* bytes skipped by padding when a record of <size> bytes is placed at index <idx>. */
+    uint32_t padding(uint32_t idx, uint32_t size) const noexcept {
+        uint32_t room = this->size_ - (idx & this->mask_);
+        return size > room ? room : 0;
+    }
+
+    /* the writable message of the record at index <idx>. */
+    std::span<std::byte> message(uint32_t idx, uint32_t n) const noexcept {
+        return {this->queue_ + (idx & this->mask_) + HEADER_SIZE, n};
+    }
+
+    /* the record owning <msg>, which is handed out by <reserve>. */
+    Header* owner(std::span<std::byte> msg) const noexcept {
+        return reinterpret_cast<Header*>(msg.data() - HEADER_SIZE);
+    }
+
+    /* check that a <n>-byte message fits in the ring at all. */
+    void check(uint32_t n) const {
+        if (n > max_message()) throw std::length_error("message is larger than the half of the ring");
+    }
+
+  public:
+    BasicByteQueue(uint32_t size, const Allocator& alloc)
+        : BasicQueue<std::byte, Allocator, Stats>(std::max(size, 2 * HEADER_SIZE), alloc) {}
+
+    BasicByteQueue(const BasicByteQueue& other) = delete;
+    BasicByteQueue& operator=(const BasicByteQueue& other) = delete;
+
+    /* the largest message accepted by <reserve>. */
+    /* a message up to half of the ring always fits once the ring is drained, whatever padding it needs. */
+    uint32_t max_message() const noexcept { return this->size_ / 2 - HEADER_SIZE; }
+};
+
+/* single producer single consumer lock-free ring of variable-length messages. */
+/* the producer fills a message in place through the span <reserve> returns and publishes it by <commit>, */
+/* the consumer reads it in place through the span <read> returns until <release>. */
+/* NOTE: one message is reserved, and one is read, at a time. */
+template <typename Allocator = std::allocator<std::byte>, typename Stats = NoStats>
+class SpscByteQueue : public BasicByteQueue<Allocator, Stats> {
+  private:
+    using Base = BasicByteQueue<Allocator, Stats>;
+    using typename Base::Header;
+    using Base::HEADER_SIZE;
+    using Base::PADDING;
+
+    // consumer's line: published read index and a cached copy of the write index
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> head_ = 0;
+    uint32_t tail_cache_ = 0;
+
+    // producer's line: published write index, where the reserved record starts and a cached read index
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> tail_ = 0;
+    uint32_t reserved_ = 0;
+    uint32_t head_cache_ = 0;
+
+  public:
+    SpscByteQueue(uint32_t size, const Allocator& alloc = Allocator()) : Base(size, alloc) {}
+
+    /* how many bytes the published records take, only a hint while others are using the queue. */
+    uint32_t size() const noexcept {
+        uint32_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    /* reserve room for a message of <n> bytes, to be written in place and published by <commit>. */
+    /* return an empty span if the ring is full now, and throw if the message could never fit. */
+    std::span<std::byte> reserve(uint32_t n) {
+        this->check(n);
+        this->stats_.count(Stat::PushAttempt);
+
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t size = Base::record_size(n), pad = this->padding(tail, size);
+        if (tail + pad + size - head_cache_ > this->size_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail + pad + size - head_cache_ > this->size_) {
+                this->stats_.count(Stat::Full);
+                return {};
+            }
+        }
+
+        // the padding is published together with the record behind it
+        if (pad != 0) *this->header(tail) = Header{pad, PADDING};
+        reserved_ = tail + pad;
+        return this->message(reserved_, n);
+    }
+
+    /* publish the message reserved as <msg>, of which only the leading <used> bytes are kept. */
+    void commit(std::span<std::byte> msg, uint32_t used) noexcept {
+        uint32_t size = Base::record_size(used);
+        *this->owner(msg) = Header{size, used};
+
+        this->stats_.count(Stat::PushSuccess);
+        if constexpr (Stats::enabled) this->stats_.watermark(reserved_ + size - head_.load(std::memory_order_relaxed));
+        tail_.store(reserved_ + size, std::memory_order_release);
+    }
+
+    /* publish the whole message reserved as <msg>. */
+    void commit(std::span<std::byte> msg) noexcept { commit(msg, static_cast<uint32_t>(msg.size())); }
+
+    /* copy <msg> to the end of the ring. */
+    /* return false if the ring is full now, otherwise true. */
+    bool push(std::span<const std::byte> msg) {
+        std::span<std::byte> dst = reserve(static_cast<uint32_t>(msg.size()));
+        if (dst.data() == nullptr) return false;
+        std::memcpy(dst.data(), msg.data(), msg.size());
+        commit(dst);
+        return true;
+    }
+
+    /* lend the message at the front of the ring, which stays valid and in place until <release>. */
+    /* return an empty span with a null data pointer if the ring is empty now. */
+    std::span<const std::byte> read() noexcept {
+        this->stats_.count(Stat::PopAttempt);
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        while (true) {
+            if (tail_cache_ == head) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if (tail_cache_ == head) {
+                    this->stats_.count(Stat::Empty);
+                    return {};
+                }
+            }
+
+            const Header* hdr = this->header(head);
+            if (hdr->length != PADDING) {
+                this->stats_.count(Stat::PopSuccess);
+                return this->message(head, hdr->length);
+            }
+            head += hdr->size;
+            head_.store(head, std::memory_order_release);
+        }
+    }
+
+    /* give the message lent by <read> back to the producer. */
+    void release() noexcept {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        head_.store(head + this->header(head)->size, std::memory_order_release);
+    }
+};
+
+/* multiple producers single consumer lock-free ring of variable-length messages. */
+/* producers claim records by a CAS on the write index and commit them in any order, each by storing the size */
+/* into its header; the consumer reads records in the order they were claimed, so a record claimed but not yet */
+/* committed holds back the ones behind it. */
+/* NOTE: the consumer zeroes every record it releases, so that the header of a record claimed later reads as */
+/* uncommitted, which costs a memset of the consumed bytes. */
+/* NOTE: one message is read at a time, every producer may hold any number of reserved ones. */
+template <typename Allocator = std::allocator<std::byte>, typename Stats = NoStats>
+class MpscByteQueue : public BasicByteQueue<Allocator, Stats> {
+  private:
+    using Base = BasicByteQueue<Allocator, Stats>;
+    using typename Base::Header;
+    using Base::HEADER_SIZE;
+    using Base::PADDING;
+
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> head_ = 0;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> tail_ = 0;
+
+    /* publish <hdr> to the consumer, which acquires the size first. */
+    static void publish(Header* hdr, uint32_t size, uint32_t length) noexcept {
+        hdr->length = length;
+        std::atomic_ref<uint32_t>(hdr->size).store(size, std::memory_order_release);
+    }
+
+  public:
+    MpscByteQueue(uint32_t size, const Allocator& alloc = Allocator()) : Base(size, alloc) {
+        std::memset(this->queue_, 0, this->size_);
+    }
+
+    /* how many bytes the claimed records take, only a hint while others are using the queue. */
+    uint32_t size() const noexcept {
+        uint32_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    /* reserve room for a message of <n> bytes, to be written in place and published by <commit>. */
+    /* return an empty span if the ring is full now, and throw if the message could never fit. */
+    std::span<std::byte> reserve(uint32_t n) {
+        this->check(n);
+        this->stats_.count(Stat::PushAttempt);
+
+        uint32_t size = Base::record_size(n), tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t pad = this->padding(tail, size);
+            // acquire so the zeroes the consumer wrote into the released records are visible
+            if (tail + pad + size - head_.load(std::memory_order_acquire) > this->size_) {
+                this->stats_.count(Stat::Full);
+                return {};
+            }
+
+            if (tail_.compare_exchange_weak(tail, tail + pad + size, std::memory_order_relaxed)) {
+                if (pad != 0) publish(this->header(tail), pad, PADDING);
+                if constexpr (Stats::enabled) {
+                    this->stats_.watermark(tail + pad + size - head_.load(std::memory_order_relaxed));
+                }
+                return this->message(tail + pad, n);
+            }
+            this->stats_.count(Stat::CasRetry);
+        }
+    }
+
+    /* publish the message reserved as <msg>, of which only the leading <used> bytes are read. */
+    /* NOTE: the record keeps the room reserved for the whole message, since those behind it are claimed already. */
+    void commit(std::span<std::byte> msg, uint32_t used) noexcept {
+        this->stats_.count(Stat::PushSuccess);
+        publish(this->owner(msg), Base::record_size(static_cast<uint32_t>(msg.size())), used);
+    }
+
+    /* publish the whole message reserved as <msg>. */
+    void commit(std::span<std::byte> msg) noexcept { commit(msg, static_cast<uint32_t>(msg.size())); }
+
+    /* copy <msg> to the end of the ring. */
+    /* return false if the ring is full now, otherwise true. */
+    bool push(std::span<const std::byte> msg) {
+        std::span<std::byte> dst = reserve(static_cast<uint32_t>(msg.size()));
+        if (dst.data() == nullptr) return false;
+        std::memcpy(dst.data(), msg.data(), msg.size());
+        commit(dst);
+        return true;
+    }
+
+    /* lend the message at the front of the ring, which stays valid and in place until <release>. */
+    /* return an empty span with a null data pointer if the ring is empty, or its front is not committed now. */
+    std::span<const std::byte> read() noexcept {
+        this->stats_.count(Stat::PopAttempt);
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Header* hdr = this->header(head);
+            uint32_t size = std::atomic_ref<uint32_t>(hdr->size).load(std::memory_order_acquire);
+            if (size == 0) {
+                this->stats_.count(Stat::Empty);
+                return {};
+            }
+
+            if (hdr->length != PADDING) {
+                this->stats_.count(Stat::PopSuccess);
+                return this->message(head, hdr->length);
+            }
+            std::memset(hdr, 0, size);
+            head += size;
+            head_.store(head, std::memory_order_release);
+        }
+    }
+
+    /* give the message lent by <read> back to the producers. */
+    void release() noexcept {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        Header* hdr = this->header(head);
+        uint32_t size = hdr->size;
+        std::memset(hdr, 0, size);
+        head_.store(head + size, std::memory_order_release);
+    }
+};
+
+}  // namespace lfcq
@@ -0,0 +1,147 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <utility>
+#include "awaitable.hpp"
+#include "unbounded_queue.hpp"
+#include "utils.hpp"
+#include "wait.hpp"
+
+namespace lfcq {
+
+class LoopScheduler;
+
+/* coroutine returning nothing, started by <LoopScheduler::spawn>, which frees its frame once it finishes. */
+/* NOTE: the coroutine is suspended at the beginning, a task never spawned frees the frame on destruction. */
+/* NOTE: coroutines are forbidden to throw exception. */
+class AsyncTask {
+  public:
+    struct promise_type {
+        LoopScheduler* scheduler = nullptr;
+
+        AsyncTask get_return_object() noexcept {
+            return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept;
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+  private:
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit AsyncTask(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    friend class LoopScheduler;
+
+  public:
+    AsyncTask(const AsyncTask& other) = delete;
+    AsyncTask& operator=(const AsyncTask& other) = delete;
+
+    AsyncTask(AsyncTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    AsyncTask& operator=(AsyncTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~AsyncTask() {
+        if (handle_) handle_.destroy();
+    }
+};
+
+/* single-threaded scheduler running coroutines one at a time on the thread calling <run>, in the order they */
+/* are scheduled, both the spawned ones and those handed back by the queues they were suspended on. */
+/* NOTE: <schedule> may be called from any thread, the thread running the loop parks while nothing is ready. */
+/* NOTE: once <run> returns the scheduler is no longer touched, and may be destructed. */
+/* NOTE: neither copyable nor movable. */
+class LoopScheduler {
+    friend struct AsyncTask::promise_type;
+
+  private:
+    UnboundedQueue<std::coroutine_handle<>> ready_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> live_ = 0;  // spawned coroutines not yet finished
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> wake_ = 0;  // bumped to wake the loop once parked
+    std::atomic<uint32_t> busy_ = 0;                          // threads inside <schedule> or <finish>
+    Parking parking_;
+    WaitPolicy idle_;
+
+    /* wake the loop if it is parked, after what it waits for has been published. */
+    void wake() noexcept {
+        // the queue publishes with release only, so fence before checking for the loop going to park
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parking_.waiting()) {
+            wake_.fetch_add(1, std::memory_order_seq_cst);
+            parking_.notify(wake_);
+        }
+    }
+
+    /* count a spawned coroutine out. */
+    void finish() noexcept {
+        busy_.fetch_add(1, std::memory_order_relaxed);
+        live_.fetch_sub(1, std::memory_order_seq_cst);
+        wake();
+        busy_.fetch_sub(1, std::memory_order_release);
+    }
+
+  public:
+    /* construct a scheduler whose loop escalates from spinning to parking according to <idle>. */
+    explicit LoopScheduler(const WaitPolicy& idle = WaitPolicy()) : idle_(idle) {}
+
+    LoopScheduler(const LoopScheduler& other) = delete;
+    LoopScheduler& operator=(const LoopScheduler& other) = delete;
+
+    /* resume the coroutine <handle> on the loop. */
+    /* NOTE: it only fails if a new segment of the ready queue can not be allocated, which terminates. */
+    void schedule(std::coroutine_handle<> handle) noexcept {
+        busy_.fetch_add(1, std::memory_order_relaxed);
+        ready_.push(handle);
+        wake();
+        busy_.fetch_sub(1, std::memory_order_release);
+    }
+
+    /* take over <task> and start it on the loop. */
+    void spawn(AsyncTask task) noexcept {
+        std::coroutine_handle<AsyncTask::promise_type> handle = std::exchange(task.handle_, nullptr);
+        handle.promise().scheduler = this;
+        live_.fetch_add(1, std::memory_order_relaxed);
+        schedule(handle);
+    }
+
+    /* run coroutines until every spawned one has finished, parking while all of them are suspended. */
+    void run() noexcept {
+        std::coroutine_handle<> handle;
+        auto take = [&handle](std::coroutine_handle<>& obj) { handle = obj; };
+
+        while (true) {
+            bool taken = false;
+            auto poll = [&]() {
+                taken = ready_.pop(take);
+                return taken || live_.load(std::memory_order_seq_cst) == 0;
+            };
+            parking_.wait(wake_, poll, idle_);
+
+            if (!taken) break;
+            handle.resume();
+        }
+
+        // the last coroutine may have been handed back or finished on another thread still waking the loop
+        while (busy_.load(std::memory_order_acquire) != 0) {
+            cpuRelax();
+        }
+    }
+};
+
+inline std::suspend_never AsyncTask::promise_type::final_suspend() noexcept {
+    // nothing of the scheduler is touched after this, so a loop on another thread is free to return
+    if (scheduler != nullptr) scheduler->finish();
+    return {};
+}
+
+}  // namespace lfcq
@@ -0,0 +1,339 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "utils.hpp"
+#include "wait.hpp"
+
+namespace lfcq {
+
+/* type-erased callable run exactly once, stored by value in the queues of <Executor>. */
+/* a callable which is nothrow move constructible and fits into <INLINE_SIZE> pointer-aligned bytes lives in the */
+/* task itself, anything else is moved to the heap and the task only keeps the pointer. */
+/* the callable is destructed right after it runs, or with the task if it never runs. */
+/* NOTE: available for moving but not for copying, a moved-from task is empty. */
+/* NOTE: constructing a task throws whatever allocating the heap storage or copying/moving the callable throws. */
+class Task {
+  public:
+    static constexpr size_t INLINE_SIZE = 56;
+
+  private:
+    // what a task does with the callable in its storage, one table for each type of callable
+    struct Ops {
+        void (*invoke)(void* storage) noexcept;           // run the callable and destruct it
+        void (*relocate)(void* from, void* to) noexcept;  // move the callable to another storage
+        void (*destroy)(void* storage) noexcept;          // destruct the callable without running it
+    };
+
+    template <typename Fn>
+    static constexpr Ops INLINE_OPS = {
+        [](void* storage) noexcept {
+            Fn* fn = std::launder(static_cast<Fn*>(storage));
+            (*fn)();
+            fn->~Fn();
+        },
+        [](void* from, void* to) noexcept {
+            Fn* fn = std::launder(static_cast<Fn*>(from));
+            new (to) Fn(std::move(*fn));
+            fn->~Fn();
+        },
+        [](void* storage) noexcept { std::launder(static_cast<Fn*>(storage))->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops HEAP_OPS = {
+        [](void* storage) noexcept {
+            Fn* fn = *std::launder(static_cast<Fn**>(storage));
+            (*fn)();
+            delete fn;
+        },
+        [](void* from, void* to) noexcept { new (to) Fn*(*std::launder(static_cast<Fn**>(from))); },
+        [](void* storage) noexcept { delete *std::launder(static_cast<Fn**>(storage)); },
+    };
+
+    const Ops* ops_ = nullptr;
+    alignas(void*) std::byte storage_[INLINE_SIZE];
+
+  public:
+    Task() = default;
+
+    template <typename F>
+    explicit Task(F&& func) requires(!std::same_as<std::decay_t<F>, Task>) && std::invocable<std::decay_t<F>&> {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(void*) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            new (storage_) Fn(std::forward<F>(func));
+            ops_ = &INLINE_OPS<Fn>;
+        } else {
+            new (storage_) Fn*(new Fn(std::forward<F>(func)));
+            ops_ = &HEAP_OPS<Fn>;
+        }
+    }
+
+    ~Task() {
+        if (ops_ != nullptr) ops_->destroy(storage_);
+    }
+
+    Task(const Task& other) = delete;
+    Task& operator=(const Task& other) = delete;
+
+    Task(Task&& other) noexcept : ops_(std::exchange(other.ops_, nullptr)) {
+        if (ops_ != nullptr) ops_->relocate(other.storage_, storage_);
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (ops_ != nullptr) ops_->destroy(storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+            if (ops_ != nullptr) ops_->relocate(other.storage_, storage_);
+        }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    /* run the callable, which leaves the task empty. */
+    void operator()() noexcept { std::exchange(ops_, nullptr)->invoke(storage_); }
+};
+static_assert(sizeof(Task) == 64);
+
+class Executor;
+
+/* result of a task submitted to <Executor>, whose state lives in the future itself rather than on the heap. */
+/* NOTE: neither copyable nor movable, the running task writes its result right here. */
+/* NOTE: destructing the future waits until the task has finished with it. */
+template <typename R>
+class Future {
+    friend class Executor;
+
+  private:
+    using Value = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+    // 0 while pending, 1 once the result is set, 2 once the worker no longer touches the future
+    std::atomic<uint32_t> state_;
+    Parking waiters_;
+    std::optional<Value> value_;
+
+    template <typename F>
+    Future(Executor& executor, F&& func);
+
+  public:
+    Future(const Future& other) = delete;
+    Future& operator=(const Future& other) = delete;
+
+    ~Future() {
+        wait();
+        while (state_.load(std::memory_order_acquire) != 2) {
+            cpuRelax();
+        }
+    }
+
+    /* whether the result has been set. */
+    bool ready() const noexcept { return state_.load(std::memory_order_acquire) != 0; }
+
+    /* wait until the result is set, escalating from spinning to sleeping according to <policy>. */
+    void wait(const WaitPolicy& policy = WaitPolicy()) noexcept {
+        waiters_.wait(state_, [this]() { return ready(); }, policy);
+    }
+
+    /* wait for the result and take it out, which can be done once. */
+    R get(const WaitPolicy& policy = WaitPolicy()) noexcept {
+        wait(policy);
+        if constexpr (!std::is_void_v<R>) return std::move(*value_);
+    }
+};
+
+/* options of <Executor>. */
+struct ExecutorOptions {
+    uint32_t workers = 0;      // 0 for one worker per hardware thread
+    std::vector<int> cpus;     // worker i is pinned to cpus[i % cpus.size()], none pinned if empty
+    uint32_t inbox = 256;      // capacity of the SPSC inbox of each worker
+    uint32_t overflow = 4096;  // capacity of the shared MPMC queue
+    WaitPolicy idle;           // how long idle workers spin before they park
+};
+
+/* pool of fixed worker threads running <Task>s. */
+/* the thread constructing the executor is its owner, whose submissions go round-robin through per-worker SPSC */
+/* inboxes, while submissions of any other thread, workers included, and those finding an inbox full go through */
+/* one shared MPMC overflow queue, which blocks the submitter while it is full, or makes a worker run the task. */
+/* workers drain their own inbox before the overflow queue, and park after spinning when both are empty. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: tasks are forbidden to throw exception. */
+/* NOTE: posting or submitting a callable throws if wrapping it into a task does, a task already built never throws. */
+/* NOTE: destructing the executor runs every task submitted before, and nothing may be submitted afterwards. */
+class Executor {
+  private:
+    struct alignas(CACHELINE_SIZE) Worker {
+        SpscQueue<Task> inbox;
+        alignas(CACHELINE_SIZE) std::atomic<uint32_t> wake = 0;  // bumped to wake the worker once parked
+        Parking parking;
+        std::thread thread;
+
+        explicit Worker(uint32_t size) : inbox(size) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    MpmcUniqueQueue<Task, std::allocator<Task>, NoStats, PauseBackoff, true> overflow_;  // blocks full submitters
+    WaitPolicy idle_;
+    std::thread::id owner_;
+    uint32_t next_ = 0;  // the inbox the owner tries first, touched by the owner only
+    alignas(CACHELINE_SIZE) std::atomic<bool> stopping_ = false;
+
+    // the executor whose worker the calling thread is, if any
+    static inline thread_local Executor* current_ = nullptr;
+
+    /* wake <worker> if it is parked, after what it waits for has been published. */
+    static void wake(Worker& worker) noexcept {
+        // the inbox publishes with release only, so fence before checking for the worker going to park
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.parking.waiting()) {
+            worker.wake.fetch_add(1, std::memory_order_seq_cst);
+            worker.parking.notify(worker.wake);
+        }
+    }
+
+    void run(Worker& worker) noexcept {
+        current_ = this;
+        Task task;
+        auto take = [&task](Task& obj) { task = std::move(obj); };
+
+        while (true) {
+            // the task is moved out first, so a long one holds no place of the queues
+            bool taken = false;
+            auto poll = [&]() {
+                taken = worker.inbox.pop(take) || overflow_.pop(take);
+                return taken || stopping_.load(std::memory_order_seq_cst);
+            };
+            worker.parking.wait(worker.wake, poll, idle_);
+
+            if (!taken) return;
+            task();
+        }
+    }
+
+    static void pin(std::thread& thread, int cpu) noexcept {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+
+  public:
+    explicit Executor(const ExecutorOptions& options = ExecutorOptions())
+        : overflow_(options.overflow), idle_(options.idle), owner_(std::this_thread::get_id()) {
+        uint32_t cnt = options.workers != 0 ? options.workers : std::max(1U, std::thread::hardware_concurrency());
+        for (uint32_t i = 0; i < cnt; i++) {
+            workers_.push_back(std::make_unique<Worker>(options.inbox));
+        }
+
+        // every worker is in place before any of them starts
+        for (uint32_t i = 0; i < cnt; i++) {
+            Worker& worker = *workers_[i];
+            worker.thread = std::thread([this, &worker]() { run(worker); });
+            if (!options.cpus.empty()) pin(worker.thread, options.cpus[i % options.cpus.size()]);
+        }
+    }
+
+    Executor(const Executor& other) = delete;
+    Executor& operator=(const Executor& other) = delete;
+
+    ~Executor() {
+        stopping_.store(true, std::memory_order_seq_cst);
+        for (auto& worker : workers_) {
+            wake(*worker);
+        }
+        for (auto& worker : workers_) {
+            worker->thread.join();
+        }
+
+        // the workers only return with the queues drained, so this destructs unrun what was posted too late
+        auto drop = [](Task&) {};
+        for (auto& worker : workers_) {
+            while (worker->inbox.pop(drop)) {}
+        }
+        while (overflow_.pop(drop)) {}
+    }
+
+    /* how many worker threads there are. */
+    uint32_t size() const noexcept { return static_cast<uint32_t>(workers_.size()); }
+
+    /* run <task> on some worker, without a way to learn when it has finished. */
+    void post(Task task) noexcept {
+        if (std::this_thread::get_id() == owner_) {
+            for (uint32_t i = 0; i < workers_.size(); i++) {
+                Worker& worker = *workers_[next_];
+                next_ = next_ + 1 == workers_.size() ? 0 : next_ + 1;
+                if (worker.inbox.push(std::move(task))) {
+                    wake(worker);
+                    return;
+                }
+            }
+        }
+
+        // a worker blocked on a full overflow queue may be what keeps it full, so it runs the task itself
+        if (current_ == this) {
+            if (!overflow_.push(std::move(task))) {
+                task();
+                return;
+            }
+        } else {
+            overflow_.push_wait(std::move(task));
+        }
+
+        for (auto& worker : workers_) {
+            if (worker->parking.waiting()) {
+                wake(*worker);
+                return;
+            }
+        }
+    }
+
+    /* same as <post>, wrapping a callable into a task. */
+    template <typename F>
+    void post(F&& func) requires(!std::same_as<std::decay_t<F>, Task>) && std::invocable<std::decay_t<F>&> {
+        post(Task(std::forward<F>(func)));
+    }
+
+    /* run <func> on some worker, and return the future of its result. */
+    template <typename F>
+    Future<std::invoke_result_t<std::decay_t<F>&>> submit(F&& func) {
+        return Future<std::invoke_result_t<std::decay_t<F>&>>(*this, std::forward<F>(func));
+    }
+};
+
+template <typename R>
+template <typename F>
+Future<R>::Future(Executor& executor, F&& func) : state_(0) {
+    // the future is constructed right where the caller keeps it, so the task can point at it
+    executor.post([this, func = std::forward<F>(func)]() mutable {
+        if constexpr (std::is_void_v<R>) {
+            func();
+            value_.emplace();
+        } else {
+            value_.emplace(func());
+        }
+
+        state_.store(1, std::memory_order_seq_cst);
+        waiters_.notify(state_);
+        state_.store(2, std::memory_order_release);
+    });
+}
+
+}  // namespace lfcq
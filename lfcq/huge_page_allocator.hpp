@@ -0,0 +1,102 @@
+#pragma once
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace lfcq {
+
+/* how the ring storage is backed, see <HugePageAllocator>. */
+struct HugePageOptions {
+    bool huge_pages = true;  // try explicit huge pages, then transparent ones, then normal pages
+    bool prefault = true;    // touch every page at allocation so the hot path never faults
+    bool lock = false;       // lock the pages in memory, skipped silently if RLIMIT_MEMLOCK forbids it
+    int numa_node = -1;      // bind the pages to this node, -1 leaves them to the node of the faulting thread
+};
+
+/* allocator mapping the ring directly from the kernel instead of the heap, usable as the <Allocator> of any queue. */
+/* the mapping is rounded up to whole huge pages, so it only pays off for rings of megabytes. */
+/* NOTE: without <numa_node>, prefaulting places the ring on the node of the constructing thread, */
+/* so construct the queue from a thread pinned to the wanted node for first-touch placement. */
+template <typename T>
+class HugePageAllocator {
+  private:
+    HugePageOptions options_;
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+    static constexpr size_t PAGE_SIZE = 4 << 10;
+
+    static size_t length(size_t n) noexcept { return (n * sizeof(T) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1); }
+
+    /* set the memory policy of the range before any page of it is faulted. */
+    static void bind(void* ptr, size_t len, int node) noexcept {
+#ifdef __linux__
+        // MPOL_BIND from <numaif.h>, which is not always installed
+        constexpr int MPOL_BIND = 2;
+        constexpr size_t BITS = sizeof(unsigned long) * 8;
+        unsigned long mask[1024 / BITS] = {};
+        if (node < 0 || static_cast<size_t>(node) >= 1024) return;
+        mask[node / BITS] = 1UL << (node % BITS);
+        syscall(SYS_mbind, ptr, len, MPOL_BIND, mask, 1024, 0);
+#endif
+    }
+
+  public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = HugePageAllocator<U>;
+    };
+
+    HugePageAllocator(const HugePageOptions& options = HugePageOptions()) noexcept : options_(options) {}
+
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>& other) noexcept : options_(other.options()) {}
+
+    const HugePageOptions& options() const noexcept { return options_; }
+
+    T* allocate(size_t n) {
+        size_t len = length(n);
+        void* ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        // explicit huge pages only exist if the administrator has reserved them
+        if (options_.huge_pages) {
+            ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+        if (ptr == MAP_FAILED) {
+            ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            // ask for transparent huge pages instead, which is only a hint
+            if (options_.huge_pages) madvise(ptr, len, MADV_HUGEPAGE);
+#endif
+        }
+
+        if (options_.numa_node >= 0) bind(ptr, len, options_.numa_node);
+        if (options_.lock) mlock(ptr, len);
+
+        // write every page so it is faulted in here rather than on the first push
+        if (options_.prefault) {
+            for (size_t off = 0; off < len; off += PAGE_SIZE) {
+                static_cast<volatile char*>(ptr)[off] = 0;
+            }
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept { munmap(ptr, length(n)); }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U>&) const noexcept {
+        return true;
+    }
+};
+
+}  // namespace lfcq
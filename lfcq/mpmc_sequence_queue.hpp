@@ -0,0 +1,225 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include "backoff.hpp"
+#include "basic_queue.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* element of the sequence queue, whose sequence tells which round of push or pop the slot is ready for. */
+template <typename T>
+struct SequenceSlot {
+    std::atomic<uint32_t> seq;
+    T data;
+};
+
+/* multiple producer multiple consumer lock-free circular queue based on per-slot sequence numbers. */
+/* ONLY ONE consumer allowed to manipulate a certain element simultaneously. */
+/* every producer or consumer only synchronizes on its own slot, so there is no ordered commit to wait for. */
+/* NOTE: available for moving but not for copying. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: user can customize the memory allocator for the queue, which is rebound to the slot type. */
+/* NOTE: elements are constructed on push and destructed after the pop handle, those left with the queue. */
+/* NOTE: producers or consumers losing a slot to one another wait according to <Backoff> before trying again. */
+template <typename T, typename Allocator = std::allocator<T>, typename Stats = NoStats,
+          BackoffPolicy Backoff = PauseBackoff>
+class MpmcSequenceQueue
+    : public BasicQueue<SequenceSlot<T>,
+                        typename std::allocator_traits<Allocator>::template rebind_alloc<SequenceSlot<T>>, Stats> {
+  private:
+    using Slot = SequenceSlot<T>;
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using Base = BasicQueue<Slot, SlotAllocator, Stats>;
+
+    // each index lives on its own cache line so producers and consumers never share one
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_w_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_r_;
+
+    /* try to acquire a slot for writing at <idx_w>, return nullptr if the queue is full now. */
+    Slot* acquire_w(uint32_t& idx_w) noexcept {
+        this->stats_.count(Stat::PushAttempt);
+        idx_w = next_w_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        while (true) {
+            Slot& slot = this->queue_[idx_w & this->mask_];
+            int32_t diff = static_cast<int32_t>(slot.seq.load(std::memory_order_acquire) - idx_w);
+
+            // the slot is still occupied by the element of the previous round
+            if (diff < 0) {
+                this->stats_.count(Stat::Full);
+                return nullptr;
+            }
+
+            if (diff == 0 && next_w_.compare_exchange_weak(idx_w, idx_w + 1, std::memory_order_relaxed)) {
+                this->stats_.count(Stat::PushSuccess);
+                if constexpr (Stats::enabled) {
+                    this->stats_.watermark(idx_w + 1 - next_r_.load(std::memory_order_relaxed));
+                }
+                return &slot;
+            }
+
+            // another producer has taken the slot
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+            if (diff > 0) idx_w = next_w_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /* try to lock down a slot for reading at <idx_r>, return nullptr if the queue is empty now. */
+    Slot* acquire_r(uint32_t& idx_r) noexcept {
+        this->stats_.count(Stat::PopAttempt);
+        idx_r = next_r_.load(std::memory_order_relaxed);
+        Backoff backoff;
+        while (true) {
+            Slot& slot = this->queue_[idx_r & this->mask_];
+            int32_t diff = static_cast<int32_t>(slot.seq.load(std::memory_order_acquire) - (idx_r + 1));
+
+            // the slot has not been written in this round yet
+            if (diff < 0) {
+                this->stats_.count(Stat::Empty);
+                return nullptr;
+            }
+
+            if (diff == 0 && next_r_.compare_exchange_weak(idx_r, idx_r + 1, std::memory_order_relaxed)) {
+                this->stats_.count(Stat::PopSuccess);
+                return &slot;
+            }
+
+            // another consumer has taken the slot
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+            if (diff > 0) idx_r = next_r_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /* destruct the elements not yet popped, while nobody is using the queue. */
+    void destroy_elements() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            if (this->queue_ == nullptr) return;
+            uint32_t idx_w = next_w_.load(std::memory_order_relaxed);
+            for (uint32_t i = next_r_.load(std::memory_order_relaxed); i != idx_w; i++) {
+                destroySlot(this->queue_[i & this->mask_].data);
+            }
+        }
+    }
+
+  public:
+    /* construct a queue of at least <size> elements, and at least 2, since with a single slot the sequence */
+    /* ready for a push and the one ready for a pop coincide. */
+    MpmcSequenceQueue(uint32_t size, const Allocator& alloc = Allocator())
+        : Base(std::max(size, 2U), SlotAllocator(alloc)) {
+        // slot i is ready for the push of index i
+        for (uint32_t i = 0; i < this->size_; i++) {
+            new (&this->queue_[i].seq) std::atomic<uint32_t>(i);
+        }
+    }
+
+    ~MpmcSequenceQueue() { destroy_elements(); }
+
+    MpmcSequenceQueue(const MpmcSequenceQueue& other) = delete;
+    MpmcSequenceQueue& operator=(const MpmcSequenceQueue& other) = delete;
+
+    MpmcSequenceQueue(MpmcSequenceQueue&& other) noexcept : Base(std::move(other)) {
+        next_w_.store(other.next_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        next_r_.store(other.next_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    MpmcSequenceQueue& operator=(MpmcSequenceQueue&& other) noexcept {
+        if (this != &other) {
+            destroy_elements();
+
+            next_w_.store(other.next_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            next_r_.store(other.next_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+            Base::operator=(std::move(other));
+        }
+        return *this;
+    }
+
+    /* push an object to the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) noexcept requires RelatedTo<U, T> {
+        uint32_t idx_w;
+        Slot* slot = acquire_w(idx_w);
+        if (slot == nullptr) return false;
+
+        constructSlot(slot->data, std::forward<U>(obj));
+
+        // hand the slot over to the consumer of the same round
+        slot->seq.store(idx_w + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_w;
+        Slot* slot = acquire_w(idx_w);
+        if (slot == nullptr) return false;
+
+        initializeSlot(slot->data);
+        handle(slot->data);
+
+        // hand the slot over to the consumer of the same round
+        slot->seq.store(idx_w + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* directly construct an object at the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename... Args>
+    bool emplace(Args&&... args) noexcept {
+        uint32_t idx_w;
+        Slot* slot = acquire_w(idx_w);
+        if (slot == nullptr) return false;
+
+        constructSlot(slot->data, std::forward<Args>(args)...);
+
+        // hand the slot over to the consumer of the same round
+        slot->seq.store(idx_w + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* pop an object from the front of the queue, and handle it with the callback user provides. */
+    /* return false if the queue is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_r;
+        Slot* slot = acquire_r(idx_r);
+        if (slot == nullptr) return false;
+
+        handle(slot->data);
+        destroySlot(slot->data);
+
+        // hand the slot over to the producer of the next round
+        slot->seq.store(idx_r + this->size_, std::memory_order_release);
+        return true;
+    }
+
+    /* pop an object from the front of the queue and move it to <out>. */
+    /* return false if the queue is empty now, otherwise true. */
+    bool try_pop(T& out) noexcept {
+        return pop([&out](T& obj) { out = std::move(obj); });
+    }
+
+    /* pop an object from the front of the queue and move it out, return nothing if the queue is empty now. */
+    std::optional<T> try_pop() noexcept {
+        std::optional<T> out;
+        pop([&out](T& obj) { out.emplace(std::move(obj)); });
+        return out;
+    }
+
+    /* compatible interface for type-erased push handle, prefer the templated one. */
+    bool push(PushHandle<T>&& handle) noexcept { return push<PushHandle<T>&>(handle); }
+
+    /* compatible interface for type-erased pop handle, prefer the templated one. */
+    bool pop(PopHandle<T>&& handle) noexcept { return pop<PopHandle<T>&>(handle); }
+};
+
+}  // namespace lfcq
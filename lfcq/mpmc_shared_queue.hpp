@@ -1,7 +1,13 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <iterator>
+#include "backoff.hpp"
 #include "basic_queue.hpp"
+#include "stats.hpp"
 #include "utils.hpp"
+#include "wait.hpp"
 
 namespace lfcq {
 
@@ -10,110 +16,294 @@ namespace lfcq {
 /* NOTE: available for moving but not for copying. */
 /* NOTE: all callbacks provided by user are forbidden to throw exception. */
 /* NOTE: user can customize the memory allocator for the queue. */
-template <typename T, typename Allocator = std::allocator<T>>
-class MpmcSharedQueue : public BasicQueue<T, Allocator> {
+/* NOTE: blocking interfaces sleep on the index of the opposite side, which is woken only if someone sleeps. */
+/* NOTE: the blocking interfaces exist only if <Waitable>, without it nothing is notified. */
+/* NOTE: consumers may still be reading an element after it is popped, so every slot stays constructed for the */
+/* lifetime of the queue and pushes assign to it, T must be default constructible or trivially copyable. */
+/* NOTE: failed CAS and ordered commits wait according to <Backoff> before trying again. */
+template <typename T, typename Allocator = std::allocator<T>, typename Stats = NoStats,
+          BackoffPolicy Backoff = PauseBackoff, bool Waitable = false>
+class MpmcSharedQueue : public BasicQueue<T, Allocator, Stats> {
   private:
-    std::atomic<uint32_t> next_w_;
-    std::atomic<uint32_t> done_w_;
-    std::atomic<uint32_t> done_r_;
+    // each index lives on its own cache line so producers and consumers never share one
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_w_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_w_;
+    [[no_unique_address]] ParkingOf<Waitable> readers_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_r_;
+    [[no_unique_address]] ParkingOf<Waitable> writers_;
+
+    /* try to acquire at most <n> places for writing, which start from <idx_w> on return. */
+    /* return how many places are acquired, 0 if the queue is full now. */
+    uint32_t acquire_w(uint32_t& idx_w, uint32_t n) noexcept {
+        this->stats_.count(Stat::PushAttempt);
+        idx_w = next_w_.load(std::memory_order_acquire);
+        Backoff backoff;
+        while (true) {
+            uint32_t cnt = std::min(n, this->size_ - (idx_w - done_r_));
+            if (cnt == 0) {
+                this->stats_.count(Stat::Full);
+                return 0;
+            }
+
+            if (next_w_.compare_exchange_weak(idx_w, idx_w + cnt)) {
+                this->stats_.count(Stat::PushSuccess);
+                if constexpr (Stats::enabled) this->stats_.watermark(idx_w + cnt - done_r_);
+                return cnt;
+            }
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+        }
+    }
+
+    /* mark the <n> places starting from <idx_w> have done after all the earlier writes. */
+    void commit_w(uint32_t idx_w, uint32_t n) noexcept {
+        for (Backoff backoff; done_w_ != idx_w; backoff()) {
+            this->stats_.count(Stat::CommitSpin);
+        }
+
+        if constexpr (Waitable) {
+            // seq_cst so a consumer going to sleep either sees the new index or gets notified
+            done_w_.fetch_add(n, std::memory_order_seq_cst);
+            readers_.notify(done_w_);
+        } else {
+            done_w_.fetch_add(n, std::memory_order_acq_rel);
+        }
+    }
 
   public:
-    MpmcSharedQueue(uint32_t size, const Allocator& alloc = Allocator()) : BasicQueue<T, Allocator>(size, alloc) {}
+    MpmcSharedQueue(uint32_t size, const Allocator& alloc = Allocator())
+        : BasicQueue<T, Allocator, Stats>(size, alloc) {
+        this->construct_all();
+    }
+
+    ~MpmcSharedQueue() { this->destroy_all(); }
 
     MpmcSharedQueue(const MpmcSharedQueue& other) = delete;
     MpmcSharedQueue& operator=(const MpmcSharedQueue& other) = delete;
 
-    MpmcSharedQueue(MpmcSharedQueue&& other) noexcept : BasicQueue<T, Allocator>(std::move(other)) {
-        next_w_ = other.next_w_;
-        done_w_ = other.done_w_;
-        done_r_ = other.done_r_;
+    MpmcSharedQueue(MpmcSharedQueue&& other) noexcept : BasicQueue<T, Allocator, Stats>(std::move(other)) {
+        next_w_.store(other.next_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        done_w_.store(other.done_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        done_r_.store(other.done_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
 
     MpmcSharedQueue& operator=(MpmcSharedQueue&& other) noexcept {
-        if (this != other) {
-            next_w_ = other.next_w_;
-            done_w_ = other.done_w_;
-            done_r_ = other.done_r_;
+        if (this != &other) {
+            this->destroy_all();
+
+            next_w_.store(other.next_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            done_w_.store(other.done_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            done_r_.store(other.done_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 
-            BasicQueue<T, Allocator>::operator=(std::move(other));
+            BasicQueue<T, Allocator, Stats>::operator=(std::move(other));
         }
         return *this;
     }
 
+    /* how many places are free for pushes, those claimed by pushes still in progress counted as taken. */
+    /* only a hint while others are using the queue. */
+    uint32_t room() const noexcept {
+        // the write index never falls behind the read index, so reading it last keeps the difference non-negative,
+        // while pops in between may make it exceed the capacity
+        uint32_t idx_r = done_r_.load(std::memory_order_acquire);
+        uint32_t used = next_w_.load(std::memory_order_acquire) - idx_r;
+        return this->size_ - std::min(used, this->size_);
+    }
+
     /* push an object to the end of the queue. */
     /* return false if the queue is full now, otherwise true. */
     template <typename U>
     bool push(U&& obj) noexcept requires RelatedTo<U, T> {
-        // try to acquire a place for the current push
-        uint32_t idx_w = next_w_.load(std::memory_order_acquire);
-        do {
-            if (idx_w - done_r_ == this->size_) return false;
-        } while (!next_w_.compare_exchange_weak(idx_w, idx_w + 1));
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
 
-        this->queue_[idx_w & this->mask_] = std::forward<T>(obj);
+        this->queue_[idx_w & this->mask_] = std::forward<U>(obj);
 
         // mark the current push has done after writing
-        while (done_w_ != idx_w) {}
-        done_w_.fetch_add(1, std::memory_order_acq_rel);
+        commit_w(idx_w, 1);
         return true;
     }
 
     /* call this push interface when you wish to manually initialize the object. */
     /* return false if the queue is full now, otherwise true. */
-    bool push(PushHandle<T>&& handle) noexcept {
-        // try to acquire a place for the current push
-        uint32_t idx_w = next_w_.load(std::memory_order_acquire);
-        do {
-            if (idx_w - done_r_ == this->size_) return false;
-        } while (!next_w_.compare_exchange_weak(idx_w, idx_w + 1));
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
 
         handle(this->queue_[idx_w & this->mask_]);
 
         // mark the current push has done after initializing
-        while (done_w_ != idx_w) {}
-        done_w_.fetch_add(1, std::memory_order_acq_rel);
+        commit_w(idx_w, 1);
         return true;
     }
 
-    /* directly construct an object at the end of the queue. */
+    /* construct an object from <args> and move it to the end of the queue. */
     /* return false if the queue is full now, otherwise true. */
-    /* NOTE: the object created through <emplace> interface will NOT be destructed */
-    /* automatically, invoke its destructor explicitly in pop handle if necessary. */
     template <typename... Args>
     bool emplace(Args&&... args) noexcept {
-        // try to acquire a place for the current emplacement
-        uint32_t idx_w = next_w_.load(std::memory_order_acquire);
-        do {
-            if (idx_w - done_r_ == this->size_) return false;
-        } while (!next_w_.compare_exchange_weak(idx_w, idx_w + 1));
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
 
-        new (&this->queue_[idx_w & this->mask_]) T(std::forward<Args>(args)...);
+        this->queue_[idx_w & this->mask_] = T(std::forward<Args>(args)...);
 
         // mark the current emplacement has done after writing
-        while (done_w_ != idx_w) {}
-        done_w_.fetch_add(1, std::memory_order_acq_rel);
+        commit_w(idx_w, 1);
         return true;
     }
 
     /* pop an object from the front of the queue, and handle it with the callback user provides. */
     /* make sure the handle is available for concurrently applied to a same element(e.g. copy it). */
     /* return false if the queue is empty now, otherwise true. */
-    bool pop(PopHandle<T>&& handle) noexcept {
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        this->stats_.count(Stat::PopAttempt);
+
         // if another consumer has committed its manipulation on the element
         // retry to handle the next until the queue is empty
         uint32_t idx_r = done_r_.load(std::memory_order_acquire);
-        do {
-            if (idx_r == done_w_) return false;
+        Backoff backoff;
+        while (true) {
+            if (idx_r == done_w_) {
+                this->stats_.count(Stat::Empty);
+                return false;
+            }
             handle(this->queue_[idx_r & this->mask_]);
-        } while (!done_r_.compare_exchange_weak(idx_r, idx_r + 1));
 
+            if (done_r_.compare_exchange_weak(idx_r, idx_r + 1)) break;
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+        }
+
+        this->stats_.count(Stat::PopSuccess);
+        if constexpr (Waitable) writers_.notify(done_r_);
         return true;
     }
 
-#ifndef NDEBUG
-    /* enabled in debug mode to dump the content of the queue.*/
-    void dump(std::string&& path) { BasicQueue<T>::dump(done_r_, done_w_, std::move(path)); }
-#endif
+    /* push objects in range [first, last) to the end of the queue as a whole. */
+    /* return how many objects from <first> were pushed, fewer than requested if the queue is nearly full. */
+    template <std::forward_iterator It>
+    uint32_t push_bulk(It first, It last) noexcept requires std::assignable_from<T&, std::iter_reference_t<It>> {
+        uint32_t n = static_cast<uint32_t>(std::min<size_t>(std::distance(first, last), this->size_));
+
+        uint32_t idx_w, cnt = acquire_w(idx_w, n);
+        for (uint32_t i = 0; i < cnt; i++, ++first) {
+            this->queue_[(idx_w + i) & this->mask_] = *first;
+        }
+
+        if (cnt != 0) commit_w(idx_w, cnt);
+        return cnt;
+    }
+
+    /* acquire at most <n> places at the end of the queue and initialize each one with the callback. */
+    /* return how many objects were pushed, fewer than requested if the queue is nearly full. */
+    template <typename F>
+    uint32_t push_bulk(F&& handle, uint32_t n) noexcept requires Handle<F, T> {
+        uint32_t idx_w, cnt = acquire_w(idx_w, n);
+        for (uint32_t i = 0; i < cnt; i++) {
+            handle(this->queue_[(idx_w + i) & this->mask_]);
+        }
+
+        if (cnt != 0) commit_w(idx_w, cnt);
+        return cnt;
+    }
+
+    /* pop at most <max> objects from the front of the queue and handle them in order with the callback. */
+    /* make sure the handle is available for concurrently applied to a same element(e.g. copy it). */
+    /* return how many objects were popped, 0 if the queue is empty now. */
+    template <typename F>
+    uint32_t pop_bulk(F&& handle, uint32_t max) noexcept requires Handle<F, T> {
+        this->stats_.count(Stat::PopAttempt);
+
+        // the whole range is handled again if another consumer has committed any part of it
+        uint32_t cnt, idx_r = done_r_.load(std::memory_order_acquire);
+        Backoff backoff;
+        while (true) {
+            cnt = std::min(max, done_w_ - idx_r);
+            if (cnt == 0) {
+                this->stats_.count(Stat::Empty);
+                return 0;
+            }
+            for (uint32_t i = 0; i < cnt; i++) {
+                handle(this->queue_[(idx_r + i) & this->mask_]);
+            }
+
+            if (done_r_.compare_exchange_weak(idx_r, idx_r + cnt)) break;
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+        }
+
+        this->stats_.count(Stat::PopSuccess);
+        if constexpr (Waitable) writers_.notify(done_r_);
+        return cnt;
+    }
+
+    /* pop at most <max> objects from the front of the queue and copy them to <out> in order. */
+    /* the iterator must be multi-pass since the copies are written again when the range is lost. */
+    /* return how many objects were popped, 0 if the queue is empty now. */
+    template <std::forward_iterator It>
+    uint32_t pop_bulk(It out, uint32_t max) noexcept requires std::output_iterator<It, const T&> {
+        this->stats_.count(Stat::PopAttempt);
+
+        uint32_t cnt, idx_r = done_r_.load(std::memory_order_acquire);
+        Backoff backoff;
+        while (true) {
+            cnt = std::min(max, done_w_ - idx_r);
+            if (cnt == 0) {
+                this->stats_.count(Stat::Empty);
+                return 0;
+            }
+            It cur = out;
+            for (uint32_t i = 0; i < cnt; i++, ++cur) {
+                *cur = this->queue_[(idx_r + i) & this->mask_];
+            }
+
+            if (done_r_.compare_exchange_weak(idx_r, idx_r + cnt)) break;
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+        }
+
+        this->stats_.count(Stat::PopSuccess);
+        if constexpr (Waitable) writers_.notify(done_r_);
+        return cnt;
+    }
+
+    /* push an object, or initialize one with the callback, at the end of the queue. */
+    /* wait until there is room for it, escalating from spinning to sleeping according to <policy>. */
+    template <typename U>
+    void push_wait(U&& obj, const WaitPolicy& policy = WaitPolicy()) noexcept
+        requires Waitable && (RelatedTo<U, T> || Handle<U, T>) {
+        writers_.wait(done_r_, [&]() { return push(std::forward<U>(obj)); }, policy);
+    }
+
+    /* pop an object from the front of the queue and handle it with the callback. */
+    /* wait until there is one, escalating from spinning to sleeping according to <policy>. */
+    template <typename F>
+    void pop_wait(F&& handle, const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        readers_.wait(done_w_, [&]() { return pop(handle); }, policy);
+    }
+
+    /* same as <pop_wait> but give up after <timeout>. */
+    /* return false if the queue is still empty when it times out, otherwise true. */
+    template <typename F, typename Rep, typename Period>
+    bool pop_for(F&& handle, const std::chrono::duration<Rep, Period>& timeout,
+                 const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        return pop_until(handle, std::chrono::steady_clock::now() + timeout, policy);
+    }
+
+    /* same as <pop_wait> but give up at <deadline>. */
+    /* return false if the queue is still empty at the deadline, otherwise true. */
+    template <typename F, typename Clock, typename Duration>
+    bool pop_until(F&& handle, const std::chrono::time_point<Clock, Duration>& deadline,
+                   const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        return readers_.wait(done_w_, [&]() { return pop(handle); }, deadline, policy);
+    }
+
+    /* compatible interface for type-erased push handle, prefer the templated one. */
+    bool push(PushHandle<T>&& handle) noexcept { return push<PushHandle<T>&>(handle); }
+
+    /* compatible interface for type-erased pop handle, prefer the templated one. */
+    bool pop(PopHandle<T>&& handle) noexcept { return pop<PopHandle<T>&>(handle); }
 };
 
 }  // namespace lfcq
\ No newline at end of file
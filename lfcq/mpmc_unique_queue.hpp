@@ -1,7 +1,16 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <iterator>
+#include <optional>
+#include "awaitable.hpp"
+#include "backoff.hpp"
 #include "basic_queue.hpp"
+#include "stats.hpp"
+#include "token.hpp"
 #include "utils.hpp"
+#include "wait.hpp"
 
 namespace lfcq {
 
@@ -10,115 +19,400 @@ namespace lfcq {
 /* NOTE: available for moving but not for copying. */
 /* NOTE: all callbacks provided by user are forbidden to throw exception. */
 /* NOTE: user can customize the memory allocator for the queue. */
-template <typename T, typename Allocator = std::allocator<T>>
-class MpmcUniqueQueue : public BasicQueue<T, Allocator> {
+/* NOTE: blocking interfaces sleep on the index of the opposite side, which is woken only if someone sleeps. */
+/* NOTE: awaitable interfaces suspend the coroutine instead, which the opposite side resumes through a scheduler. */
+/* NOTE: a consumer in an event loop watches <fd> instead, which a push makes readable once it is armed. */
+/* NOTE: the blocking, awaitable and event interfaces exist only if <Waitable>, without it commits are published */
+/* with plain read-modify-writes and nothing is notified. */
+/* NOTE: elements are constructed on push and destructed after the pop handle, those left with the queue. */
+/* NOTE: failed CAS and ordered commits wait according to <Backoff> before trying again. */
+template <typename T, typename Allocator = std::allocator<T>, typename Stats = NoStats,
+          BackoffPolicy Backoff = PauseBackoff, bool Waitable = false>
+class MpmcUniqueQueue : public BasicQueue<T, Allocator, Stats> {
   private:
-    std::atomic<uint32_t> next_w_;
-    std::atomic<uint32_t> done_w_;
-    std::atomic<uint32_t> next_r_;
-    std::atomic<uint32_t> done_r_;
+    // each index lives on its own cache line so producers and consumers never share one
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_w_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_w_;
+    [[no_unique_address]] ParkingOf<Waitable> readers_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_r_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_r_;
+    [[no_unique_address]] ParkingOf<Waitable> writers_;
+
+    /* try to acquire at most <n> places for writing, which start from <idx_w> on return. */
+    /* return how many places are acquired, 0 if the queue is full now. */
+    uint32_t acquire_w(uint32_t& idx_w, uint32_t n) noexcept {
+        this->stats_.count(Stat::PushAttempt);
+        idx_w = next_w_.load(std::memory_order_acquire);
+        Backoff backoff;
+        while (true) {
+            uint32_t cnt = std::min(n, this->size_ - (idx_w - done_r_));
+            if (cnt == 0) {
+                this->stats_.count(Stat::Full);
+                return 0;
+            }
+
+            if (next_w_.compare_exchange_weak(idx_w, idx_w + cnt)) {
+                this->stats_.count(Stat::PushSuccess);
+                if constexpr (Stats::enabled) this->stats_.watermark(idx_w + cnt - done_r_);
+                return cnt;
+            }
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+        }
+    }
+
+    /* mark the <n> places starting from <idx_w> have done after all the earlier writes. */
+    void commit_w(uint32_t idx_w, uint32_t n) noexcept {
+        for (Backoff backoff; done_w_ != idx_w; backoff()) {
+            this->stats_.count(Stat::CommitSpin);
+        }
+
+        if constexpr (Waitable) {
+            // seq_cst so a consumer going to sleep either sees the new index or gets notified
+            done_w_.fetch_add(n, std::memory_order_seq_cst);
+            if (readers_.notify(done_w_)) this->stats_.count(Stat::Signal);
+        } else {
+            done_w_.fetch_add(n, std::memory_order_acq_rel);
+        }
+    }
+
+    /* try to lock down at most <n> elements for reading, which start from <idx_r> on return. */
+    /* return how many elements are locked down, 0 if the queue is empty now. */
+    uint32_t acquire_r(uint32_t& idx_r, uint32_t n) noexcept {
+        this->stats_.count(Stat::PopAttempt);
+        idx_r = next_r_.load(std::memory_order_acquire);
+        Backoff backoff;
+        while (true) {
+            uint32_t cnt = std::min(n, done_w_ - idx_r);
+            if (cnt == 0) {
+                this->stats_.count(Stat::Empty);
+                return 0;
+            }
+
+            if (next_r_.compare_exchange_weak(idx_r, idx_r + cnt)) {
+                this->stats_.count(Stat::PopSuccess);
+                return cnt;
+            }
+            this->stats_.count(Stat::CasRetry);
+            backoff();
+        }
+    }
+
+    /* mark the <n> elements starting from <idx_r> have done after all the earlier reads. */
+    void commit_r(uint32_t idx_r, uint32_t n) noexcept {
+        for (Backoff backoff; done_r_ != idx_r; backoff()) {
+            this->stats_.count(Stat::CommitSpin);
+        }
+
+        if constexpr (Waitable) {
+            // seq_cst so a producer going to sleep either sees the new index or gets notified
+            done_r_.fetch_add(n, std::memory_order_seq_cst);
+            writers_.notify(done_r_);
+        } else {
+            done_r_.fetch_add(n, std::memory_order_acq_rel);
+        }
+    }
+
+    /* destruct the elements not yet popped, while nobody is using the queue. */
+    void destroy_elements() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            if (this->queue_ == nullptr) return;
+            uint32_t idx_w = done_w_.load(std::memory_order_relaxed);
+            for (uint32_t i = done_r_.load(std::memory_order_relaxed); i != idx_w; i++) {
+                destroySlot(this->queue_[i & this->mask_]);
+            }
+        }
+    }
+
+    friend class WriteToken<T, MpmcUniqueQueue>;
+    friend class ReadToken<T, MpmcUniqueQueue>;
+
+    void commit_token(uint32_t idx_w) noexcept { commit_w(idx_w, 1); }
+
+    void release_token(uint32_t idx_r) noexcept {
+        destroySlot(this->queue_[idx_r & this->mask_]);
+        commit_r(idx_r, 1);
+    }
 
   public:
-    MpmcUniqueQueue(uint32_t size, const Allocator& alloc = Allocator()) : BasicQueue<T, Allocator>(size, alloc) {}
+    MpmcUniqueQueue(uint32_t size, const Allocator& alloc = Allocator())
+        : BasicQueue<T, Allocator, Stats>(size, alloc) {}
+
+    ~MpmcUniqueQueue() { destroy_elements(); }
 
     MpmcUniqueQueue(const MpmcUniqueQueue& other) = delete;
     MpmcUniqueQueue& operator=(const MpmcUniqueQueue& other) = delete;
 
-    MpmcUniqueQueue(MpmcUniqueQueue&& other) noexcept : BasicQueue<T, Allocator>(std::move(other)) {
-        next_w_ = other.next_w_;
-        done_w_ = other.done_w_;
-        next_r_ = other.next_r_;
-        done_r_ = other.done_r_;
+    MpmcUniqueQueue(MpmcUniqueQueue&& other) noexcept : BasicQueue<T, Allocator, Stats>(std::move(other)) {
+        next_w_.store(other.next_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        done_w_.store(other.done_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        next_r_.store(other.next_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        done_r_.store(other.done_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
 
     MpmcUniqueQueue& operator=(MpmcUniqueQueue&& other) noexcept {
-        if (this != other) {
-            next_w_ = other.next_w_;
-            done_w_ = other.done_w_;
-            next_r_ = other.next_r_;
-            done_r_ = other.done_r_;
+        if (this != &other) {
+            destroy_elements();
+
+            next_w_.store(other.next_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            done_w_.store(other.done_w_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            next_r_.store(other.next_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            done_r_.store(other.done_r_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 
-            BasicQueue<T, Allocator>::operator=(std::move(other));
+            BasicQueue<T, Allocator, Stats>::operator=(std::move(other));
         }
         return *this;
     }
 
+    /* how many committed elements are not yet taken, only a hint while others are using the queue. */
+    uint32_t size() const noexcept {
+        // the read index never passes the write index, so reading it first keeps the difference non-negative
+        uint32_t idx_r = next_r_.load(std::memory_order_acquire);
+        return done_w_.load(std::memory_order_acquire) - idx_r;
+    }
+
+    /* how many places are free for pushes, those claimed by pushes still in progress counted as taken. */
+    /* only a hint while others are using the queue. */
+    uint32_t room() const noexcept {
+        // the write index never falls behind the read index, so reading it last keeps the difference non-negative,
+        // while pops in between may make it exceed the capacity
+        uint32_t idx_r = done_r_.load(std::memory_order_acquire);
+        uint32_t used = next_w_.load(std::memory_order_acquire) - idx_r;
+        return this->size_ - std::min(used, this->size_);
+    }
+
     /* push an object to the end of the queue. */
     /* return false if the queue is full now, otherwise true. */
     template <typename U>
     bool push(U&& obj) noexcept requires RelatedTo<U, T> {
-        // try to acquire a place for the current push
-        uint32_t idx_w = next_w_.load(std::memory_order_acquire);
-        do {
-            if (idx_w - done_r_ == this->size_) return false;
-        } while (!next_w_.compare_exchange_weak(idx_w, idx_w + 1));
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
 
-        this->queue_[idx_w & this->mask_] = std::forward<T>(obj);
+        constructSlot(this->queue_[idx_w & this->mask_], std::forward<U>(obj));
 
         // mark the current push has done after writing
-        while (done_w_ != idx_w) {}
-        done_w_.fetch_add(1, std::memory_order_acq_rel);
+        commit_w(idx_w, 1);
         return true;
     }
 
     /* call this push interface when you wish to manually initialize the object. */
     /* return false if the queue is full now, otherwise true. */
-    bool push(PushHandle<T>&& handle) noexcept {
-        // try to acquire a place for the current push
-        uint32_t idx_w = next_w_.load(std::memory_order_acquire);
-        do {
-            if (idx_w - done_r_ == this->size_) return false;
-        } while (!next_w_.compare_exchange_weak(idx_w, idx_w + 1));
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
 
-        handle(this->queue_[idx_w & this->mask_]);
+        T& slot = this->queue_[idx_w & this->mask_];
+        initializeSlot(slot);
+        handle(slot);
 
         // mark the current push has done after initializing
-        while (done_w_ != idx_w) {}
-        done_w_.fetch_add(1, std::memory_order_acq_rel);
+        commit_w(idx_w, 1);
         return true;
     }
 
     /* directly construct an object at the end of the queue. */
     /* return false if the queue is full now, otherwise true. */
-    /* NOTE: the object overwritten by <emplace> interface will NOT be destructed */
-    /* automatically, invoke its destructor explicitly in pop handle if necessary. */
     template <typename... Args>
     bool emplace(Args&&... args) noexcept {
-        // try to acquire a place for the current emplacement
-        uint32_t idx_w = next_w_.load(std::memory_order_acquire);
-        do {
-            if (idx_w - done_r_ == this->size_) return false;
-        } while (!next_w_.compare_exchange_weak(idx_w, idx_w + 1));
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return false;
 
-        new (&this->queue_[idx_w & this->mask_]) T(std::forward<Args>(args)...);
+        constructSlot(this->queue_[idx_w & this->mask_], std::forward<Args>(args)...);
 
         // mark the current emplacement has done after writing
-        while (done_w_ != idx_w) {}
-        done_w_.fetch_add(1, std::memory_order_acq_rel);
+        commit_w(idx_w, 1);
         return true;
     }
 
     /* pop an object from the front of the queue, and handle it with the callback user provides. */
     /* return false if the queue is empty now, otherwise true. */
-    bool pop(PopHandle<T>&& handle) noexcept {
-        // try to lock down a index and pop element from it
-        uint32_t idx_r = next_r_.load(std::memory_order_acquire);
-        do {
-            if (idx_r == done_w_) return false;
-        } while (!next_r_.compare_exchange_weak(idx_r, idx_r + 1));
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_r;
+        if (acquire_r(idx_r, 1) == 0) return false;
 
-        handle(this->queue_[idx_r & this->mask_]);
+        T& slot = this->queue_[idx_r & this->mask_];
+        handle(slot);
+        destroySlot(slot);
 
         // mark the current pop has done after handling the element
-        while (done_r_ != idx_r) {}
-        done_r_.fetch_add(1, std::memory_order_acq_rel);
+        commit_r(idx_r, 1);
         return true;
     }
 
-#ifndef NDEBUG
-    /* enabled in debug mode to dump the content of the queue.*/
-    void dump(std::string&& path) { BasicQueue<T>::dump(done_r_, done_w_, std::move(path)); }
+    /* pop an object from the front of the queue and move it to <out>. */
+    /* return false if the queue is empty now, otherwise true. */
+    bool try_pop(T& out) noexcept {
+        return pop([&out](T& obj) { out = std::move(obj); });
+    }
+
+    /* pop an object from the front of the queue and move it out, return nothing if the queue is empty now. */
+    std::optional<T> try_pop() noexcept {
+        std::optional<T> out;
+        pop([&out](T& obj) { out.emplace(std::move(obj)); });
+        return out;
+    }
+
+    /* push objects in range [first, last) to the end of the queue as a whole. */
+    /* contiguous trivially copyable objects are copied with memcpy, or with streaming stores given <Mode>. */
+    /* return how many objects from <first> were pushed, fewer than requested if the queue is nearly full. */
+    template <CopyMode Mode = CopyMode::Regular, std::forward_iterator It>
+    uint32_t push_bulk(It first, It last) noexcept requires std::constructible_from<T, std::iter_reference_t<It>> {
+        uint32_t n = static_cast<uint32_t>(std::min<size_t>(std::distance(first, last), this->size_));
+
+        uint32_t idx_w, cnt = acquire_w(idx_w, n);
+        if constexpr (Memcpyable<It, T>) {
+            if (cnt != 0) this->template copy_in<Mode>(idx_w, std::to_address(first), cnt);
+        } else {
+            static_assert(Mode == CopyMode::Regular, "only contiguous trivially copyable objects can be streamed");
+            for (uint32_t i = 0; i < cnt; i++, ++first) {
+                constructSlot(this->queue_[(idx_w + i) & this->mask_], *first);
+            }
+        }
+
+        if (cnt != 0) commit_w(idx_w, cnt);
+        return cnt;
+    }
+
+    /* acquire at most <n> places at the end of the queue and initialize each one with the callback. */
+    /* return how many objects were pushed, fewer than requested if the queue is nearly full. */
+    template <typename F>
+    uint32_t push_bulk(F&& handle, uint32_t n) noexcept requires Handle<F, T> {
+        uint32_t idx_w, cnt = acquire_w(idx_w, n);
+        for (uint32_t i = 0; i < cnt; i++) {
+            T& slot = this->queue_[(idx_w + i) & this->mask_];
+            initializeSlot(slot);
+            handle(slot);
+        }
+
+        if (cnt != 0) commit_w(idx_w, cnt);
+        return cnt;
+    }
+
+    /* pop at most <max> objects from the front of the queue and handle them in order with the callback. */
+    /* return how many objects were popped, 0 if the queue is empty now. */
+    template <typename F>
+    uint32_t pop_bulk(F&& handle, uint32_t max) noexcept requires Handle<F, T> {
+        uint32_t idx_r, cnt = acquire_r(idx_r, max);
+        for (uint32_t i = 0; i < cnt; i++) {
+            T& slot = this->queue_[(idx_r + i) & this->mask_];
+            handle(slot);
+            destroySlot(slot);
+        }
+
+        if (cnt != 0) commit_r(idx_r, cnt);
+        return cnt;
+    }
+
+    /* pop at most <max> objects from the front of the queue and move them to <out> in order. */
+    /* contiguous trivially copyable objects are copied straight into the buffer of <out> with memcpy. */
+    /* return how many objects were popped, 0 if the queue is empty now. */
+    template <std::output_iterator<T> It>
+    uint32_t pop_bulk(It out, uint32_t max) noexcept {
+        if constexpr (Memcpyable<It, T>) {
+            uint32_t idx_r, cnt = acquire_r(idx_r, max);
+            if (cnt != 0) {
+                this->copy_out(idx_r, std::to_address(out), cnt);
+                commit_r(idx_r, cnt);
+            }
+            return cnt;
+        } else {
+            return pop_bulk([&out](T& obj) { *out++ = std::move(obj); }, max);
+        }
+    }
+
+    /* reserve a place at the end of the queue, to be filled in place through the token and published later. */
+    /* return an empty token if the queue is full now. */
+    /* NOTE: commits are ordered, a token blocks on commit until all the earlier reserved ones are committed, */
+    /* so a thread holding several tokens must commit them in the order they were reserved. */
+    WriteToken<T, MpmcUniqueQueue> reserve() noexcept {
+        uint32_t idx_w;
+        if (acquire_w(idx_w, 1) == 0) return {};
+
+        T& slot = this->queue_[idx_w & this->mask_];
+        initializeSlot(slot);
+        return {this, &slot, idx_w};
+    }
+
+    /* lend the element at the front of the queue, to be read in place through the token and released later. */
+    /* return an empty token if the queue is empty now. */
+    /* NOTE: releases are ordered in the same way as commits of <reserve>. */
+    ReadToken<T, MpmcUniqueQueue> peek() noexcept {
+        uint32_t idx_r;
+        if (acquire_r(idx_r, 1) == 0) return {};
+        return {this, &this->queue_[idx_r & this->mask_], idx_r};
+    }
+
+    /* push an object, or initialize one with the callback, at the end of the queue. */
+    /* wait until there is room for it, escalating from spinning to sleeping according to <policy>. */
+    template <typename U>
+    void push_wait(U&& obj, const WaitPolicy& policy = WaitPolicy()) noexcept
+        requires Waitable && (RelatedTo<U, T> || Handle<U, T>) {
+        writers_.wait(done_r_, [&]() { return push(std::forward<U>(obj)); }, policy);
+    }
+
+    /* pop an object from the front of the queue and handle it with the callback. */
+    /* wait until there is one, escalating from spinning to sleeping according to <policy>. */
+    template <typename F>
+    void pop_wait(F&& handle, const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        readers_.wait(done_w_, [&]() { return pop(handle); }, policy);
+    }
+
+    /* same as <pop_wait> but give up after <timeout>. */
+    /* return false if the queue is still empty when it times out, otherwise true. */
+    template <typename F, typename Rep, typename Period>
+    bool pop_for(F&& handle, const std::chrono::duration<Rep, Period>& timeout,
+                 const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        return pop_until(handle, std::chrono::steady_clock::now() + timeout, policy);
+    }
+
+    /* same as <pop_wait> but give up at <deadline>. */
+    /* return false if the queue is still empty at the deadline, otherwise true. */
+    template <typename F, typename Clock, typename Duration>
+    bool pop_until(F&& handle, const std::chrono::time_point<Clock, Duration>& deadline,
+                   const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        return readers_.wait(done_w_, [&]() { return pop(handle); }, deadline, policy);
+    }
+
+    /* pop an object from the front of the queue in a coroutine, co_await the result for the object. */
+    /* it completes at once if the queue has one, otherwise the coroutine is suspended until a push brings one, */
+    /* and then resumed through <scheduler> on the pushing thread, right within the push by default. */
+    template <Scheduler S = InlineScheduler>
+    PopAwaitable<T, MpmcUniqueQueue, S> async_pop(S& scheduler = inline_scheduler) noexcept requires Waitable {
+        return {*this, readers_, scheduler};
+    }
+
+    /* push an object to the end of the queue in a coroutine, co_await the result for it to complete. */
+    /* it completes at once if the queue has room, otherwise the coroutine is suspended until a pop makes room, */
+    /* and then resumed through <scheduler> on the popping thread, right within the pop by default. */
+    template <typename U, Scheduler S = InlineScheduler>
+    PushAwaitable<T, MpmcUniqueQueue, S> async_push(U&& obj, S& scheduler = inline_scheduler) noexcept
+        requires Waitable && RelatedTo<U, T> {
+        return {*this, writers_, scheduler, std::forward<U>(obj)};
+    }
+
+#ifdef __linux__
+    /* eventfd to be watched by epoll, which becomes readable on the first push after <arm>. */
+    /* it is created on the first call, throws if it can not be, and is closed with the queue. */
+    /* NOTE: the fd stays with this queue object, a queue moved from it creates its own. */
+    int fd() requires Waitable { return readers_.event_fd(); }
+
+    /* arm <fd> for the next push once the queue looks drained, which also reads the event that woke the loop. */
+    /* return false if the queue is not empty now, the fd is left unarmed then and popping should go on. */
+    /* a typical event loop pops until the queue is empty and arms, and waits for the fd only once armed, so */
+    /* pushes make system calls only when the consumer has run out of elements. */
+    /* NOTE: only one thread at a time arms the fd, a stale event may wake it once with nothing to pop. */
+    bool arm() requires Waitable {
+        return readers_.arm([this]() { return size() != 0; });
+    }
 #endif
+
+    /* compatible interface for type-erased push handle, prefer the templated one. */
+    bool push(PushHandle<T>&& handle) noexcept { return push<PushHandle<T>&>(handle); }
+
+    /* compatible interface for type-erased pop handle, prefer the templated one. */
+    bool pop(PopHandle<T>&& handle) noexcept { return pop<PopHandle<T>&>(handle); }
 };
 
-}  // namespace lfcq
\ No newline at end of file
+}  // namespace lfcq
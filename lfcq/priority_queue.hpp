@@ -0,0 +1,142 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include "mpmc_unique_queue.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* anti-starvation weighting owned by one consumer of <PriorityQueue>: */
+/* after <high> elements in a row from the highest non-empty level while lower levels wait, */
+/* up to <low> elements are taken from the next non-empty level below it. */
+struct Fairness {
+    uint32_t high;
+    uint32_t low;
+    uint32_t taken = 0;  // elements taken from the highest level since the last lower one
+    uint32_t owed = 0;   // elements still to take from a lower level
+};
+
+/* lock-free queue of <Levels> priorities, one <Queue> ring each, level 0 being the highest. */
+/* a bitmask of the levels that may be non-empty finds the highest one to pop from with a single <ctz>. */
+/* elements of one level keep the order of <Queue>, nothing is ordered between levels. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+template <typename T, uint32_t Levels, typename Queue = MpmcUniqueQueue<T>>
+class PriorityQueue {
+    static_assert(Levels > 0 && Levels <= 64, "levels must fit into the non-empty bitmask");
+
+  private:
+    // a bit is set after an element is pushed to its level, and cleared only by a consumer
+    // which finds the level empty and then checks it once more
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> mask_;
+    std::array<std::optional<Queue>, Levels> queues_;  // constructed in place, queues need not be movable
+
+    /* publish that <level> holds elements, skipping the write if the bit is set already. */
+    void mark(uint32_t level) noexcept {
+        uint64_t bit = 1ULL << level;
+        // the level may publish with release only, so fence before the load, or a consumer clearing the bit
+        // could miss the element on its second look while we still see the bit set
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((mask_.load() & bit) == 0) mask_.fetch_or(bit);
+    }
+
+    /* pop from the highest level set in <candidates>, clearing the bits of levels found empty. */
+    /* return the level popped from, or <Levels> if all of them are empty now. */
+    template <typename F>
+    uint32_t take(uint64_t candidates, F& handle) noexcept {
+        while (candidates != 0) {
+            uint32_t level = std::countr_zero(candidates);
+            uint64_t bit = 1ULL << level;
+            if (queues_[level]->pop(handle)) return level;
+
+            // a producer may have pushed right before the bit is cleared, so look once more afterwards
+            mask_.fetch_and(~bit);
+            if (queues_[level]->pop(handle)) {
+                mark(level);
+                return level;
+            }
+            candidates &= ~bit;
+        }
+        return Levels;
+    }
+
+  public:
+    /* construct every level as <Queue>(<size>, <args>...). */
+    template <typename... Args>
+    explicit PriorityQueue(uint32_t size, const Args&... args) : mask_(0) {
+        for (auto& queue : queues_) {
+            queue.emplace(size, args...);
+        }
+    }
+
+    PriorityQueue(const PriorityQueue& other) = delete;
+    PriorityQueue& operator=(const PriorityQueue& other) = delete;
+
+    /* push an object to the end of <level>. */
+    /* return false if the level is full now, otherwise true. */
+    template <typename U>
+    bool push(uint32_t level, U&& obj) noexcept requires RelatedTo<U, T> {
+        if (!queues_[level]->push(std::forward<U>(obj))) return false;
+        mark(level);
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the level is full now, otherwise true. */
+    template <typename F>
+    bool push(uint32_t level, F&& handle) noexcept requires Handle<F, T> {
+        if (!queues_[level]->push(std::forward<F>(handle))) return false;
+        mark(level);
+        return true;
+    }
+
+    /* directly construct an object at the end of <level>. */
+    /* return false if the level is full now, otherwise true. */
+    template <typename... Args>
+    bool emplace(uint32_t level, Args&&... args) noexcept {
+        if (!queues_[level]->emplace(std::forward<Args>(args)...)) return false;
+        mark(level);
+        return true;
+    }
+
+    /* pop an object from the highest non-empty level, and handle it with the callback user provides. */
+    /* return false if every level is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        return take(mask_.load(std::memory_order_acquire), handle) != Levels;
+    }
+
+    /* same as <pop>, but lower levels get their share according to the consumer's <fairness>. */
+    template <typename F>
+    bool pop(F&& handle, Fairness& fairness) noexcept requires Handle<F, T> {
+        uint64_t mask = mask_.load(std::memory_order_acquire);
+
+        // pay back the levels below the highest one first
+        if (fairness.owed != 0) {
+            if (take(mask & (mask - 1), handle) != Levels) {
+                fairness.owed--;
+                return true;
+            }
+            fairness.owed = 0;
+        }
+
+        uint32_t level = take(mask, handle);
+        if (level == Levels) return false;
+
+        // only count while someone below is waiting
+        if (level + 1 < Levels && (mask >> (level + 1)) != 0 && ++fairness.taken >= fairness.high) {
+            fairness.taken = 0;
+            fairness.owed = fairness.low;
+        }
+        return true;
+    }
+
+    /* the ring behind <level>, e.g. to use its bulk or blocking interfaces. */
+    /* NOTE: pushing to it directly bypasses the bitmask, consumers of this queue may miss those elements. */
+    Queue& level(uint32_t level) noexcept { return *queues_[level]; }
+};
+
+}  // namespace lfcq
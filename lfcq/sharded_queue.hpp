@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* how consumers of <ShardedQueue> choose the shard to pop from. */
+enum class Selection {
+    RoundRobin,  // the shard after the one popped last
+    TwoChoices,  // the fuller one of two random shards
+};
+
+template <typename Q>
+inline constexpr bool is_spsc_queue = false;
+
+template <typename T, typename Allocator, typename Stats, bool Waitable>
+inline constexpr bool is_spsc_queue<SpscQueue<T, Allocator, Stats, Waitable>> = true;
+
+/* lock-free queue spread over <Shard> rings, so producers on different shards never touch the same indices. */
+/* a producer attaches to a shard, and consumers fan in from all the shards picked by <Select>. */
+/* NOTE: the order is FIFO for each producer only, elements of different producers can be popped in any order. */
+/* NOTE: with <SpscQueue> shards every shard admits one producer and the whole queue admits one consumer (MPSC), */
+/* otherwise producers share shards once there are more of them than shards (MPMC). */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+template <typename T, typename Shard = MpmcUniqueQueue<T>, Selection Select = Selection::RoundRobin>
+class ShardedQueue {
+  public:
+    // whether a shard admits only one producer
+    static constexpr bool exclusive = is_spsc_queue<Shard>;
+
+  private:
+    std::vector<std::unique_ptr<Shard>> shards_;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> attached_;
+
+    // where a consumer thread starts to look, and its random state for two choices
+    static inline thread_local uint32_t cursor_ = 0;
+    static inline thread_local uint32_t seed_ = 0;
+
+    uint32_t next(uint32_t shard) const noexcept { return shard + 1 == shards_.size() ? 0 : shard + 1; }
+
+    uint32_t random() noexcept {
+        if (seed_ == 0) seed_ = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&seed_) >> 4) | 1;
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        return seed_;
+    }
+
+    /* the shard to look at first. */
+    uint32_t select() noexcept {
+        if constexpr (Select == Selection::TwoChoices) {
+            uint32_t r = random(), n = static_cast<uint32_t>(shards_.size());
+            uint32_t a = r % n, b = (r >> 16) % n;
+            return shards_[a]->size() >= shards_[b]->size() ? a : b;
+        } else {
+            return cursor_ < shards_.size() ? cursor_ : 0;
+        }
+    }
+
+  public:
+    /* construct <shards> shards of at least <size> elements each, with <args>... passed on to <Shard>. */
+    template <typename... Args>
+    ShardedQueue(uint32_t shards, uint32_t size, const Args&... args) : attached_(0) {
+        for (uint32_t i = 0; i < std::max(shards, 1U); i++) {
+            shards_.push_back(std::make_unique<Shard>(size, args...));
+        }
+    }
+
+    ShardedQueue(const ShardedQueue& other) = delete;
+    ShardedQueue& operator=(const ShardedQueue& other) = delete;
+
+    /* register a producer, return the shard to push to. */
+    /* with exclusive shards it throws once every shard has got its producer, otherwise shards are handed out */
+    /* in turn. */
+    uint32_t attach() {
+        uint32_t id = attached_.fetch_add(1, std::memory_order_relaxed);
+        if constexpr (exclusive) {
+            if (id >= shards_.size()) {
+                attached_.fetch_sub(1, std::memory_order_relaxed);
+                throw std::length_error("every shard has got its producer");
+            }
+            return id;
+        } else {
+            return id % shards_.size();
+        }
+    }
+
+    /* push an object to the end of <shard>. */
+    /* return false if the shard is full now, otherwise true. */
+    template <typename U>
+    bool push(uint32_t shard, U&& obj) noexcept requires RelatedTo<U, T> {
+        return shards_[shard]->push(std::forward<U>(obj));
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the shard is full now, otherwise true. */
+    template <typename F>
+    bool push(uint32_t shard, F&& handle) noexcept requires Handle<F, T> {
+        return shards_[shard]->push(std::forward<F>(handle));
+    }
+
+    /* directly construct an object at the end of <shard>. */
+    /* return false if the shard is full now, otherwise true. */
+    template <typename... Args>
+    bool emplace(uint32_t shard, Args&&... args) noexcept {
+        return shards_[shard]->emplace(std::forward<Args>(args)...);
+    }
+
+    /* pop an object from some shard, and handle it with the callback user provides. */
+    /* every shard is looked at before giving up, starting from the one <Select> picks. */
+    /* return false if all the shards are empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t first = select(), shard = first;
+        do {
+            if (shards_[shard]->pop(handle)) {
+                cursor_ = next(shard);
+                return true;
+            }
+            shard = next(shard);
+        } while (shard != first);
+        return false;
+    }
+
+    /* how many elements are waiting in all the shards, only a hint while others are using the queue. */
+    uint32_t size() const noexcept {
+        uint32_t cnt = 0;
+        for (auto& shard : shards_) {
+            cnt += shard->size();
+        }
+        return cnt;
+    }
+
+    /* how many elements all the shards hold at most. */
+    uint32_t capacity() const noexcept {
+        uint32_t cnt = 0;
+        for (auto& shard : shards_) {
+            cnt += shard->capacity();
+        }
+        return cnt;
+    }
+
+    /* how many shards there are. */
+    uint32_t shards() const noexcept { return static_cast<uint32_t>(shards_.size()); }
+};
+
+}  // namespace lfcq
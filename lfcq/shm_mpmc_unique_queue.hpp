@@ -0,0 +1,129 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include "shm_segment.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* indices of <ShmMpmcUniqueQueue> in the segment, each on its own cache line. */
+struct ShmMpmcIndices {
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_w;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_w;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> next_r;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> done_r;
+};
+
+/* multiple producer multiple consumer lock-free circular queue shared between processes. */
+/* ONLY ONE consumer allowed to manipulate a certain element simultaneously. */
+/* the indices and the elements live in a shared memory segment, created and attached by name or descriptor. */
+/* NOTE: available for moving but not for copying. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: elements must be trivially copyable, and must not point into the memory of one process. */
+/* NOTE: commits are ordered, so a process dying between acquiring and committing stalls the queue. */
+template <typename T>
+class ShmMpmcUniqueQueue : public BasicShmQueue<T, ShmMpmcIndices, 2> {
+  private:
+    using Base = BasicShmQueue<T, ShmMpmcIndices, 2>;
+    using Base::Base;
+
+    /* try to acquire a place for writing at <idx_w>, return false if the queue is full now. */
+    bool acquire_w(uint32_t& idx_w) noexcept {
+        auto& idx = *this->indices_;
+        idx_w = idx.next_w.load(std::memory_order_acquire);
+        do {
+            if (idx_w - idx.done_r.load(std::memory_order_acquire) == this->size_) return false;
+        } while (!idx.next_w.compare_exchange_weak(idx_w, idx_w + 1));
+        return true;
+    }
+
+    /* mark the place at <idx_w> has done after all the earlier writes. */
+    void commit_w(uint32_t idx_w) noexcept {
+        auto& idx = *this->indices_;
+        while (idx.done_w.load(std::memory_order_acquire) != idx_w) {
+            cpuRelax();
+        }
+        idx.done_w.store(idx_w + 1, std::memory_order_release);
+    }
+
+    /* try to lock down an element for reading at <idx_r>, return false if the queue is empty now. */
+    bool acquire_r(uint32_t& idx_r) noexcept {
+        auto& idx = *this->indices_;
+        idx_r = idx.next_r.load(std::memory_order_acquire);
+        do {
+            if (idx.done_w.load(std::memory_order_acquire) == idx_r) return false;
+        } while (!idx.next_r.compare_exchange_weak(idx_r, idx_r + 1));
+        return true;
+    }
+
+    /* mark the element at <idx_r> has done after all the earlier reads. */
+    void commit_r(uint32_t idx_r) noexcept {
+        auto& idx = *this->indices_;
+        while (idx.done_r.load(std::memory_order_acquire) != idx_r) {
+            cpuRelax();
+        }
+        idx.done_r.store(idx_r + 1, std::memory_order_release);
+    }
+
+  public:
+    /* create a queue of at least <size> elements in a new segment under <name>. */
+    static ShmMpmcUniqueQueue create(const std::string& name, uint32_t size) {
+        size = alignUpPowOf2(size);
+        return ShmMpmcUniqueQueue(ShmSegment::create(name, Base::bytes(size)), size);
+    }
+
+    /* attach to the queue created under <name>. */
+    static ShmMpmcUniqueQueue attach(const std::string& name) {
+        return ShmMpmcUniqueQueue(ShmSegment::attach(name));
+    }
+
+#ifdef __linux__
+    /* create a queue of at least <size> elements in a new anonymous segment, shared through <fd>. */
+    static ShmMpmcUniqueQueue create(uint32_t size) {
+        size = alignUpPowOf2(size);
+        return ShmMpmcUniqueQueue(ShmSegment::create(Base::bytes(size)), size);
+    }
+#endif
+
+    /* attach to the queue behind <fd>. */
+    static ShmMpmcUniqueQueue attach(int fd) { return ShmMpmcUniqueQueue(ShmSegment::attach(fd)); }
+
+    /* push an object to the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) noexcept requires RelatedTo<U, T> {
+        uint32_t idx_w;
+        if (!acquire_w(idx_w)) return false;
+
+        this->queue_[idx_w & this->mask_] = std::forward<U>(obj);
+        commit_w(idx_w);
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_w;
+        if (!acquire_w(idx_w)) return false;
+
+        handle(this->queue_[idx_w & this->mask_]);
+        commit_w(idx_w);
+        return true;
+    }
+
+    /* pop an object from the front of the queue, and handle it with the callback user provides. */
+    /* return false if the queue is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t idx_r;
+        if (!acquire_r(idx_r)) return false;
+
+        handle(this->queue_[idx_r & this->mask_]);
+        commit_r(idx_r);
+        return true;
+    }
+};
+
+}  // namespace lfcq
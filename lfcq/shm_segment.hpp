@@ -0,0 +1,226 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* shared memory segment mapped into the calling process, named by <shm_open> or anonymous by <memfd_create>. */
+/* NOTE: available for moving but not for copying. */
+/* NOTE: the creator of a named segment removes the name when it is destroyed, processes already attached */
+/* keep their mapping until they are destroyed too. */
+class ShmSegment {
+  private:
+    int fd_ = -1;
+    void* addr_ = nullptr;
+    size_t len_ = 0;
+    std::string name_;  // only set on the creator of a named segment
+
+    [[noreturn]] static void fail(const char* what) { throw std::system_error(errno, std::generic_category(), what); }
+
+    void reset() noexcept {
+        if (addr_) munmap(addr_, len_);
+        if (fd_ >= 0) close(fd_);
+        if (!name_.empty()) shm_unlink(name_.c_str());
+        fd_ = -1;
+        addr_ = nullptr;
+        len_ = 0;
+        name_.clear();
+    }
+
+    ShmSegment(int fd, size_t len) : fd_(fd), len_(len) {
+        addr_ = mmap(nullptr, len_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (addr_ == MAP_FAILED) {
+            addr_ = nullptr;
+            close(fd_);
+            fail("mmap");
+        }
+    }
+
+    /* map the whole of an existing segment. */
+    static ShmSegment map(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            fail("fstat");
+        }
+        return ShmSegment(fd, static_cast<size_t>(st.st_size));
+    }
+
+  public:
+    /* create a segment of <len> bytes under <name>, fail if the name exists. */
+    static ShmSegment create(const std::string& name, size_t len) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) fail("shm_open");
+        if (ftruncate(fd, static_cast<off_t>(len)) != 0) {
+            close(fd);
+            shm_unlink(name.c_str());
+            fail("ftruncate");
+        }
+
+        ShmSegment segment(fd, len);
+        segment.name_ = name;
+        return segment;
+    }
+
+    /* attach to the segment created under <name>. */
+    static ShmSegment attach(const std::string& name) {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) fail("shm_open");
+        return map(fd);
+    }
+
+#ifdef __linux__
+    /* create an anonymous segment of <len> bytes, which is shared through <fd> by fork or SCM_RIGHTS. */
+    static ShmSegment create(size_t len) {
+        int fd = memfd_create("lfcq", 0);
+        if (fd < 0) fail("memfd_create");
+        if (ftruncate(fd, static_cast<off_t>(len)) != 0) {
+            close(fd);
+            fail("ftruncate");
+        }
+        return ShmSegment(fd, len);
+    }
+#endif
+
+    /* attach to the segment behind <fd>, which is duplicated so the caller still owns it. */
+    static ShmSegment attach(int fd) {
+        int dup_fd = dup(fd);
+        if (dup_fd < 0) fail("dup");
+        return map(dup_fd);
+    }
+
+    ~ShmSegment() { reset(); }
+
+    ShmSegment(const ShmSegment& other) = delete;
+    ShmSegment& operator=(const ShmSegment& other) = delete;
+
+    ShmSegment(ShmSegment&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)),
+          addr_(std::exchange(other.addr_, nullptr)),
+          len_(std::exchange(other.len_, 0)),
+          name_(std::move(other.name_)) {
+        other.name_.clear();
+    }
+
+    ShmSegment& operator=(ShmSegment&& other) noexcept {
+        if (this != &other) {
+            reset();
+            fd_ = std::exchange(other.fd_, -1);
+            addr_ = std::exchange(other.addr_, nullptr);
+            len_ = std::exchange(other.len_, 0);
+            name_ = std::move(other.name_);
+            other.name_.clear();
+        }
+        return *this;
+    }
+
+    int fd() const noexcept { return fd_; }
+    void* data() const noexcept { return addr_; }
+    size_t length() const noexcept { return len_; }
+};
+
+/* leading block of every queue segment, telling an attaching process what it attaches to. */
+struct ShmHeader {
+    static constexpr uint64_t MAGIC = 0x5145'5543'4643'4c00ULL;  // "\0LFCQUEQ"
+    static constexpr uint32_t VERSION = 1;
+
+    // written last by the creator, so a process seeing it can trust the rest
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t kind;       // which queue the segment is laid out for
+    uint32_t size;       // capacity of the queue
+    uint32_t elem_size;  // sizeof of the element type
+    uint64_t slots;      // offset of the slot array from the start of the segment
+};
+
+/* base of the queues living in shared memory, which owns the mapping and validates the header. */
+/* <Indices> is the control block of the derived queue, placed on its own cache lines after the header. */
+/* every process keeps its own <queue_> pointer, only offsets are stored in the segment. */
+/* NOTE: only trivially copyable elements can be shared, and only through always lock-free atomics. */
+template <typename T, typename Indices, uint32_t Kind>
+class BasicShmQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "elements in shared memory must be trivially copyable");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                  "atomics in shared memory must be lock-free");
+
+  private:
+    struct Layout {
+        alignas(CACHELINE_SIZE) ShmHeader header;
+        Indices indices;
+    };
+
+    static constexpr uint64_t SLOTS = (sizeof(Layout) + CACHELINE_SIZE - 1) & ~(CACHELINE_SIZE - 1);
+
+  protected:
+    ShmSegment segment_;
+    Indices* indices_;
+    T* queue_;
+    uint32_t size_;
+    uint32_t mask_;
+
+    /* lay out a fresh segment for a queue of <size> elements. */
+    BasicShmQueue(ShmSegment&& segment, uint32_t size) : segment_(std::move(segment)) {
+        auto* layout = new (segment_.data()) Layout();
+        layout->header.version = ShmHeader::VERSION;
+        layout->header.kind = Kind;
+        layout->header.size = size;
+        layout->header.elem_size = sizeof(T);
+        layout->header.slots = SLOTS;
+        layout->header.magic.store(ShmHeader::MAGIC, std::memory_order_release);
+
+        init(layout);
+    }
+
+    /* take over a segment laid out by another process, throw if it is not a queue of the same shape. */
+    explicit BasicShmQueue(ShmSegment&& segment) : segment_(std::move(segment)) {
+        if (segment_.length() < SLOTS) throw std::runtime_error("shared memory segment is too small");
+
+        auto* layout = static_cast<Layout*>(segment_.data());
+        if (layout->header.magic.load(std::memory_order_acquire) != ShmHeader::MAGIC) {
+            throw std::runtime_error("shared memory segment holds no queue");
+        }
+        if (layout->header.version != ShmHeader::VERSION || layout->header.kind != Kind ||
+            layout->header.elem_size != sizeof(T) || layout->header.slots != SLOTS ||
+            segment_.length() < bytes(layout->header.size)) {
+            throw std::runtime_error("shared memory segment holds another kind of queue");
+        }
+
+        init(layout);
+    }
+
+    void init(Layout* layout) noexcept {
+        indices_ = &layout->indices;
+        queue_ = reinterpret_cast<T*>(static_cast<char*>(segment_.data()) + layout->header.slots);
+        size_ = layout->header.size;
+        mask_ = size_ - 1;
+    }
+
+    /* how many bytes a segment holding <size> elements takes. */
+    static size_t bytes(uint32_t size) noexcept { return SLOTS + sizeof(T) * static_cast<size_t>(size); }
+
+  public:
+    BasicShmQueue(const BasicShmQueue& other) = delete;
+    BasicShmQueue& operator=(const BasicShmQueue& other) = delete;
+
+    BasicShmQueue(BasicShmQueue&& other) noexcept = default;
+    BasicShmQueue& operator=(BasicShmQueue&& other) noexcept = default;
+
+    /* descriptor of the segment, to be passed to another process attaching by descriptor. */
+    int fd() const noexcept { return segment_.fd(); }
+
+    uint32_t capacity() const noexcept { return size_; }
+};
+
+}  // namespace lfcq
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include "shm_segment.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* indices of <ShmSpscQueue> in the segment, each on its own cache line. */
+struct ShmSpscIndices {
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> head;
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> tail;
+};
+
+/* single producer single consumer lock-free circular queue shared between processes. */
+/* the indices and the elements live in a shared memory segment, created and attached by name or descriptor. */
+/* NOTE: available for moving but not for copying. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: elements must be trivially copyable, and must not point into the memory of one process. */
+template <typename T>
+class ShmSpscQueue : public BasicShmQueue<T, ShmSpscIndices, 1> {
+  private:
+    using Base = BasicShmQueue<T, ShmSpscIndices, 1>;
+
+    // process-local copies of the opposite index, only reloaded when they look short
+    uint32_t head_cache_;
+    uint32_t tail_cache_;
+
+    ShmSpscQueue(ShmSegment&& segment, uint32_t size) : Base(std::move(segment), size) { load(); }
+
+    explicit ShmSpscQueue(ShmSegment&& segment) : Base(std::move(segment)) { load(); }
+
+    void load() noexcept {
+        head_cache_ = this->indices_->head.load(std::memory_order_acquire);
+        tail_cache_ = this->indices_->tail.load(std::memory_order_acquire);
+    }
+
+    /* return whether there is room at <tail>, reload the read index only when it looks full. */
+    bool vacant(uint32_t tail) noexcept {
+        if (tail - head_cache_ != this->size_) return true;
+        head_cache_ = this->indices_->head.load(std::memory_order_acquire);
+        return tail - head_cache_ != this->size_;
+    }
+
+    /* return whether there is an element at <head>, reload the write index only when it looks empty. */
+    bool occupied(uint32_t head) noexcept {
+        if (tail_cache_ != head) return true;
+        tail_cache_ = this->indices_->tail.load(std::memory_order_acquire);
+        return tail_cache_ != head;
+    }
+
+  public:
+    /* create a queue of at least <size> elements in a new segment under <name>. */
+    static ShmSpscQueue create(const std::string& name, uint32_t size) {
+        size = alignUpPowOf2(size);
+        return ShmSpscQueue(ShmSegment::create(name, Base::bytes(size)), size);
+    }
+
+    /* attach to the queue created under <name>. */
+    static ShmSpscQueue attach(const std::string& name) { return ShmSpscQueue(ShmSegment::attach(name)); }
+
+#ifdef __linux__
+    /* create a queue of at least <size> elements in a new anonymous segment, shared through <fd>. */
+    static ShmSpscQueue create(uint32_t size) {
+        size = alignUpPowOf2(size);
+        return ShmSpscQueue(ShmSegment::create(Base::bytes(size)), size);
+    }
+#endif
+
+    /* attach to the queue behind <fd>. */
+    static ShmSpscQueue attach(int fd) { return ShmSpscQueue(ShmSegment::attach(fd)); }
+
+    /* push an object to the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) noexcept requires RelatedTo<U, T> {
+        uint32_t tail = this->indices_->tail.load(std::memory_order_relaxed);
+        if (!vacant(tail)) return false;
+
+        this->queue_[tail & this->mask_] = std::forward<U>(obj);
+        this->indices_->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t tail = this->indices_->tail.load(std::memory_order_relaxed);
+        if (!vacant(tail)) return false;
+
+        handle(this->queue_[tail & this->mask_]);
+        this->indices_->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* pop an object from the front of the queue, and handle it with the callback user provides. */
+    /* return false if the queue is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t head = this->indices_->head.load(std::memory_order_relaxed);
+        if (!occupied(head)) return false;
+
+        handle(this->queue_[head & this->mask_]);
+        this->indices_->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+}  // namespace lfcq
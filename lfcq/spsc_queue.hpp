@@ -1,7 +1,15 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <iterator>
+#include <optional>
+#include "awaitable.hpp"
 #include "basic_queue.hpp"
+#include "stats.hpp"
+#include "token.hpp"
 #include "utils.hpp"
+#include "wait.hpp"
 
 namespace lfcq {
 
@@ -9,89 +17,403 @@ namespace lfcq {
 /* NOTE: available for moving but not for copying. */
 /* NOTE: all callbacks provided by user are forbidden to throw exception. */
 /* NOTE: user can customize the memory allocator for the queue. */
-template <typename T, typename Allocator = std::allocator<T>>
-class SpscQueue : public BasicQueue<T, Allocator> {
+/* NOTE: in batch mode writes are published every <batch> pushes or on <flush>. */
+/* NOTE: blocking interfaces sleep on the index of the opposite side, which is woken only if someone sleeps. */
+/* NOTE: awaitable interfaces suspend the coroutine instead, which the opposite side resumes through a scheduler. */
+/* NOTE: a consumer in an event loop watches <fd> instead, which a push makes readable once it is armed. */
+/* NOTE: the blocking, awaitable and event interfaces exist only if <Waitable>, without it indices are published */
+/* with release stores and nothing is notified. */
+/* NOTE: elements are constructed on push and destructed after the pop handle, those left with the queue. */
+template <typename T, typename Allocator = std::allocator<T>, typename Stats = NoStats, bool Waitable = false>
+class SpscQueue : public BasicQueue<T, Allocator, Stats> {
   private:
-    std::atomic<uint32_t> head_;
-    std::atomic<uint32_t> tail_;
+    // consumer's line: published read index, a cached copy of the write index and the sleeping producer
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> head_;
+    uint32_t tail_cache_ = 0;
+    [[no_unique_address]] ParkingOf<Waitable> writers_;
+
+    // producer's line: published write index, the one including unpublished writes, a cached read index
+    // and the sleeping consumer
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> tail_;
+    uint32_t next_tail_ = 0;
+    uint32_t head_cache_ = 0;
+    uint32_t batch_ = 1;
+    [[no_unique_address]] ParkingOf<Waitable> readers_;
+
+    /* return how many places are free for writing, reload the read index only when it looks short of <n>. */
+    uint32_t vacancy(uint32_t n) noexcept {
+        uint32_t free = this->size_ - (next_tail_ - head_cache_);
+        if (free < n) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            free = this->size_ - (next_tail_ - head_cache_);
+
+            // pending writes must be visible or the consumer could never make room for us
+            if (free == 0) flush();
+        }
+        return free;
+    }
+
+    /* return how many elements are ready for reading, reload the write index only when it looks short of <n>. */
+    uint32_t occupancy(uint32_t head, uint32_t n) noexcept {
+        uint32_t used = tail_cache_ - head;
+        if (used < n) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            used = tail_cache_ - head;
+        }
+        return used;
+    }
+
+    /* try to acquire at most <n> places for writing from <next_tail_>, return how many are acquired. */
+    uint32_t acquire_w(uint32_t n) noexcept {
+        this->stats_.count(Stat::PushAttempt);
+        uint32_t cnt = std::min(n, vacancy(n));
+        if (cnt == 0) {
+            this->stats_.count(Stat::Full);
+            return 0;
+        }
+
+        this->stats_.count(Stat::PushSuccess);
+        if constexpr (Stats::enabled) this->stats_.watermark(next_tail_ + cnt - head_.load(std::memory_order_relaxed));
+        return cnt;
+    }
+
+    /* try to lock down at most <n> elements for reading from <head>, return how many are locked down. */
+    uint32_t acquire_r(uint32_t head, uint32_t n) noexcept {
+        this->stats_.count(Stat::PopAttempt);
+        uint32_t cnt = std::min(n, occupancy(head, n));
+        this->stats_.count(cnt == 0 ? Stat::Empty : Stat::PopSuccess);
+        return cnt;
+    }
+
+    /* count <n> more writes and publish them once the batch is full. */
+    void publish(uint32_t n) noexcept {
+        next_tail_ += n;
+        if (next_tail_ - tail_.load(std::memory_order_relaxed) >= batch_) flush();
+    }
+
+    /* publish that the elements before <head> have been read. */
+    void release(uint32_t head) noexcept {
+        if constexpr (Waitable) {
+            // seq_cst so a producer going to sleep either sees the new index or gets notified
+            head_.store(head, std::memory_order_seq_cst);
+            writers_.notify(head_);
+        } else {
+            head_.store(head, std::memory_order_release);
+        }
+    }
+
+    /* destruct the elements not yet popped, while neither side is using the queue. */
+    void destroy_elements() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            if (this->queue_ == nullptr) return;
+            for (uint32_t i = head_.load(std::memory_order_relaxed); i != next_tail_; i++) {
+                destroySlot(this->queue_[i & this->mask_]);
+            }
+        }
+    }
+
+    friend class WriteToken<T, SpscQueue>;
+    friend class ReadToken<T, SpscQueue>;
+
+    void commit_token(uint32_t) noexcept { publish(1); }
+
+    void release_token(uint32_t idx) noexcept {
+        destroySlot(this->queue_[idx & this->mask_]);
+        release(idx + 1);
+    }
 
   public:
-    SpscQueue(uint32_t size, const Allocator& alloc = Allocator()) : BasicQueue<T, Allocator>(size, alloc) {}
+    SpscQueue(uint32_t size, const Allocator& alloc = Allocator()) : BasicQueue<T, Allocator, Stats>(size, alloc) {}
+
+    /* construct a queue in batch mode, which publishes writes every <batch> pushes. */
+    SpscQueue(uint32_t size, uint32_t batch, const Allocator& alloc = Allocator())
+        : BasicQueue<T, Allocator, Stats>(size, alloc) {
+        batch_ = std::clamp(batch, 1U, this->size_);
+    }
+
+    ~SpscQueue() { destroy_elements(); }
 
     SpscQueue(const SpscQueue& other) = delete;
     SpscQueue& operator=(const SpscQueue& other) = delete;
 
-    SpscQueue(SpscQueue&& other) noexcept : BasicQueue<T, Allocator>(std::move(other)) {
-        head_ = other.head_;
-        tail_ = other.tail_;
+    SpscQueue(SpscQueue&& other) noexcept : BasicQueue<T, Allocator, Stats>(std::move(other)) {
+        head_.store(other.head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        tail_cache_ = other.tail_cache_;
+        tail_.store(other.tail_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        next_tail_ = other.next_tail_;
+        head_cache_ = other.head_cache_;
+        batch_ = other.batch_;
     }
 
     SpscQueue& operator=(SpscQueue&& other) noexcept {
         if (this != &other) {
-            head_ = other.head_;
-            tail_ = other.tail_;
+            destroy_elements();
+
+            head_.store(other.head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            tail_cache_ = other.tail_cache_;
+            tail_.store(other.tail_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            next_tail_ = other.next_tail_;
+            head_cache_ = other.head_cache_;
+            batch_ = other.batch_;
 
-            BasicQueue<T, Allocator>::operator=(std::move(other));
+            BasicQueue<T, Allocator, Stats>::operator=(std::move(other));
         }
         return *this;
     }
 
+    /* how many published elements are waiting to be read, only a hint while others are using the queue. */
+    uint32_t size() const noexcept {
+        uint32_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    /* how many places are free for pushes, only a hint while others are using the queue. */
+    /* a single producer claims no place before it publishes, except for writes pending in batch mode, which only */
+    /* the producer itself knows of, so they are not counted. */
+    uint32_t room() const noexcept { return this->size_ - size(); }
+
     /* push an object to the end of the queue. */
     /* return false if the queue is full now, otherwise true. */
     template <typename U>
     bool push(U&& obj) noexcept requires RelatedTo<U, T> {
-        uint32_t head = head_.load(std::memory_order_acquire);
-        if (tail_ - head == this->size_) return false;
+        if (acquire_w(1) == 0) return false;
 
-        this->queue_[tail_ & this->mask_] = std::forward<T>(obj);
+        constructSlot(this->queue_[next_tail_ & this->mask_], std::forward<U>(obj));
 
-        tail_.fetch_add(1, std::memory_order_acq_rel);
+        publish(1);
         return true;
     }
 
     /* call this push interface when you wish to manually initialize the object. */
     /* return false if the queue is full now, otherwise true. */
-    bool push(PushHandle<T>&& handle) noexcept {
-        uint32_t head = head_.load(std::memory_order_acquire);
-        if (tail_ - head == this->size_) return false;
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        if (acquire_w(1) == 0) return false;
 
-        handle(this->queue_[tail_ & this->mask_]);
+        T& slot = this->queue_[next_tail_ & this->mask_];
+        initializeSlot(slot);
+        handle(slot);
 
-        tail_.fetch_add(1, std::memory_order_acq_rel);
+        publish(1);
         return true;
     }
 
     /* directly construct an object at the end of the queue. */
     /* return false if the queue is full now, otherwise true. */
-    /* NOTE: the object created through <emplace> interface will NOT be destructed */
-    /* automatically, invoke its destructor explicitly in pop handle if necessary. */
     template <typename... Args>
     bool emplace(Args&&... args) noexcept {
-        uint32_t head = head_.load(std::memory_order_acquire);
-        if (tail_ - head == this->size_) return false;
+        if (acquire_w(1) == 0) return false;
 
-        new (&this->queue_[tail_ & this->mask_]) T(std::forward<Args>(args)...);
+        constructSlot(this->queue_[next_tail_ & this->mask_], std::forward<Args>(args)...);
 
-        tail_.fetch_add(1, std::memory_order_acq_rel);
+        publish(1);
         return true;
     }
 
     /* pop an object from the front of the queue, and handle it with the callback user provides. */
     /* return false if the queue is empty now, otherwise true. */
-    bool pop(PopHandle<T>&& handle) noexcept {
-        uint32_t tail = tail_.load(std::memory_order_acquire);
-        if (head_ == tail) return false;
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (acquire_r(head, 1) == 0) return false;
 
-        handle(this->queue_[head_ & this->mask_]);
+        T& slot = this->queue_[head & this->mask_];
+        handle(slot);
+        destroySlot(slot);
 
-        head_.fetch_add(1, std::memory_order_acq_rel);
+        release(head + 1);
         return true;
     }
 
-#ifndef NDEBUG
-    /* enabled in debug mode to dump the content of the queue.*/
-    void dump(std::string&& path) { BasicQueue<T>::dump(head_, tail_, std::move(path)); }
+    /* pop an object from the front of the queue and move it to <out>. */
+    /* return false if the queue is empty now, otherwise true. */
+    bool try_pop(T& out) noexcept {
+        return pop([&out](T& obj) { out = std::move(obj); });
+    }
+
+    /* pop an object from the front of the queue and move it out, return nothing if the queue is empty now. */
+    std::optional<T> try_pop() noexcept {
+        std::optional<T> out;
+        pop([&out](T& obj) { out.emplace(std::move(obj)); });
+        return out;
+    }
+
+    /* push objects in range [first, last) to the end of the queue as a whole. */
+    /* contiguous trivially copyable objects are copied with memcpy, or with streaming stores given <Mode>. */
+    /* return how many objects from <first> were pushed, fewer than requested if the queue is nearly full. */
+    template <CopyMode Mode = CopyMode::Regular, std::forward_iterator It>
+    uint32_t push_bulk(It first, It last) noexcept requires std::constructible_from<T, std::iter_reference_t<It>> {
+        uint32_t n = static_cast<uint32_t>(std::min<size_t>(std::distance(first, last), this->size_));
+        uint32_t cnt = acquire_w(n);
+        if (cnt == 0) return 0;
+
+        if constexpr (Memcpyable<It, T>) {
+            this->template copy_in<Mode>(next_tail_, std::to_address(first), cnt);
+        } else {
+            static_assert(Mode == CopyMode::Regular, "only contiguous trivially copyable objects can be streamed");
+            for (uint32_t i = 0; i < cnt; i++, ++first) {
+                constructSlot(this->queue_[(next_tail_ + i) & this->mask_], *first);
+            }
+        }
+
+        publish(cnt);
+        return cnt;
+    }
+
+    /* acquire at most <n> places at the end of the queue and initialize each one with the callback. */
+    /* return how many objects were pushed, fewer than requested if the queue is nearly full. */
+    template <typename F>
+    uint32_t push_bulk(F&& handle, uint32_t n) noexcept requires Handle<F, T> {
+        uint32_t cnt = acquire_w(n);
+        if (cnt == 0) return 0;
+
+        for (uint32_t i = 0; i < cnt; i++) {
+            T& slot = this->queue_[(next_tail_ + i) & this->mask_];
+            initializeSlot(slot);
+            handle(slot);
+        }
+
+        publish(cnt);
+        return cnt;
+    }
+
+    /* pop at most <max> objects from the front of the queue and handle them in order with the callback. */
+    /* return how many objects were popped, 0 if the queue is empty now. */
+    template <typename F>
+    uint32_t pop_bulk(F&& handle, uint32_t max) noexcept requires Handle<F, T> {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t cnt = acquire_r(head, max);
+        if (cnt == 0) return 0;
+
+        for (uint32_t i = 0; i < cnt; i++) {
+            T& slot = this->queue_[(head + i) & this->mask_];
+            handle(slot);
+            destroySlot(slot);
+        }
+
+        release(head + cnt);
+        return cnt;
+    }
+
+    /* pop at most <max> objects from the front of the queue and move them to <out> in order. */
+    /* contiguous trivially copyable objects are copied straight into the buffer of <out> with memcpy. */
+    /* return how many objects were popped, 0 if the queue is empty now. */
+    template <std::output_iterator<T> It>
+    uint32_t pop_bulk(It out, uint32_t max) noexcept {
+        if constexpr (Memcpyable<It, T>) {
+            uint32_t head = head_.load(std::memory_order_relaxed);
+            uint32_t cnt = acquire_r(head, max);
+            if (cnt == 0) return 0;
+
+            this->copy_out(head, std::to_address(out), cnt);
+
+            release(head + cnt);
+            return cnt;
+        } else {
+            return pop_bulk([&out](T& obj) { *out++ = std::move(obj); }, max);
+        }
+    }
+
+    /* publish all the writes pending in batch mode, only the producer is allowed to call it. */
+    void flush() noexcept {
+        if constexpr (Waitable) {
+            // seq_cst so a consumer going to sleep either sees the new index or gets notified
+            tail_.store(next_tail_, std::memory_order_seq_cst);
+            if (readers_.notify(tail_)) this->stats_.count(Stat::Signal);
+        } else {
+            tail_.store(next_tail_, std::memory_order_release);
+        }
+    }
+
+    /* reserve the place at the end of the queue, to be filled in place through the token and published later. */
+    /* return an empty token if the queue is full now. */
+    /* NOTE: the queue lends one place at a time, commit the token before reserving another. */
+    WriteToken<T, SpscQueue> reserve() noexcept {
+        if (acquire_w(1) == 0) return {};
+
+        T& slot = this->queue_[next_tail_ & this->mask_];
+        initializeSlot(slot);
+        return {this, &slot, next_tail_};
+    }
+
+    /* lend the element at the front of the queue, to be read in place through the token and released later. */
+    /* return an empty token if the queue is empty now. */
+    /* NOTE: the queue lends one element at a time, release the token before peeking another. */
+    ReadToken<T, SpscQueue> peek() noexcept {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (acquire_r(head, 1) == 0) return {};
+        return {this, &this->queue_[head & this->mask_], head};
+    }
+
+    /* push an object, or initialize one with the callback, at the end of the queue. */
+    /* wait until there is room for it, escalating from spinning to sleeping according to <policy>. */
+    template <typename U>
+    void push_wait(U&& obj, const WaitPolicy& policy = WaitPolicy()) noexcept
+        requires Waitable && (RelatedTo<U, T> || Handle<U, T>) {
+        writers_.wait(head_, [&]() { return push(std::forward<U>(obj)); }, policy);
+    }
+
+    /* pop an object from the front of the queue and handle it with the callback. */
+    /* wait until there is one, escalating from spinning to sleeping according to <policy>. */
+    template <typename F>
+    void pop_wait(F&& handle, const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        readers_.wait(tail_, [&]() { return pop(handle); }, policy);
+    }
+
+    /* same as <pop_wait> but give up after <timeout>. */
+    /* return false if the queue is still empty when it times out, otherwise true. */
+    template <typename F, typename Rep, typename Period>
+    bool pop_for(F&& handle, const std::chrono::duration<Rep, Period>& timeout,
+                 const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        return pop_until(handle, std::chrono::steady_clock::now() + timeout, policy);
+    }
+
+    /* same as <pop_wait> but give up at <deadline>. */
+    /* return false if the queue is still empty at the deadline, otherwise true. */
+    template <typename F, typename Clock, typename Duration>
+    bool pop_until(F&& handle, const std::chrono::time_point<Clock, Duration>& deadline,
+                   const WaitPolicy& policy = WaitPolicy()) noexcept requires Waitable && Handle<F, T> {
+        return readers_.wait(tail_, [&]() { return pop(handle); }, deadline, policy);
+    }
+
+    /* pop an object from the front of the queue in a coroutine, co_await the result for the object. */
+    /* it completes at once if the queue has one, otherwise the coroutine is suspended until a push brings one, */
+    /* and then resumed through <scheduler> on the pushing thread, right within the push by default. */
+    template <Scheduler S = InlineScheduler>
+    PopAwaitable<T, SpscQueue, S> async_pop(S& scheduler = inline_scheduler) noexcept requires Waitable {
+        return {*this, readers_, scheduler};
+    }
+
+    /* push an object to the end of the queue in a coroutine, co_await the result for it to complete. */
+    /* it completes at once if the queue has room, otherwise the coroutine is suspended until a pop makes room, */
+    /* and then resumed through <scheduler> on the popping thread, right within the pop by default. */
+    template <typename U, Scheduler S = InlineScheduler>
+    PushAwaitable<T, SpscQueue, S> async_push(U&& obj, S& scheduler = inline_scheduler) noexcept
+        requires Waitable && RelatedTo<U, T> {
+        return {*this, writers_, scheduler, std::forward<U>(obj)};
+    }
+
+#ifdef __linux__
+    /* eventfd to be watched by epoll, which becomes readable on the first push after <arm>. */
+    /* it is created on the first call, throws if it can not be, and is closed with the queue. */
+    /* NOTE: the fd stays with this queue object, a queue moved from it creates its own. */
+    int fd() requires Waitable { return readers_.event_fd(); }
+
+    /* arm <fd> for the next push once the queue looks drained, which also reads the event that woke the loop. */
+    /* return false if the queue is not empty now, the fd is left unarmed then and popping should go on. */
+    /* a typical event loop pops until the queue is empty and arms, and waits for the fd only once armed, so */
+    /* pushes make system calls only when the consumer has run out of elements. */
+    /* NOTE: only one thread at a time arms the fd, a stale event may wake it once with nothing to pop. */
+    bool arm() requires Waitable {
+        return readers_.arm([this]() { return size() != 0; });
+    }
 #endif
+
+    /* compatible interface for type-erased push handle, prefer the templated one. */
+    bool push(PushHandle<T>&& handle) noexcept { return push<PushHandle<T>&>(handle); }
+
+    /* compatible interface for type-erased pop handle, prefer the templated one. */
+    bool pop(PopHandle<T>&& handle) noexcept { return pop<PopHandle<T>&>(handle); }
 };
 
 }  // namespace lfcq
@@ -0,0 +1,314 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include "backoff.hpp"
+#include "basic_queue.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* inline storage of <N> elements of T, which are constructed and destructed by the queue owning it. */
+template <typename T, size_t N>
+class StaticStorage {
+  private:
+    struct alignas(T) Slot {
+        std::byte data[sizeof(T)];
+    };
+    std::array<Slot, N> slots_;
+
+  public:
+    T& operator[](size_t idx) noexcept { return *std::launder(reinterpret_cast<T*>(slots_[idx].data)); }
+};
+
+/* check the capacity <N> of a static queue against its index type. */
+/* indices run freely and wrap around, they tell a full queue from an empty one as long as they count */
+/* at least twice the capacity. */
+template <typename Index, size_t N>
+inline constexpr bool validStaticCapacity() {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of 2");
+    static_assert(N <= (std::numeric_limits<Index>::max() >> 1) + size_t(1), "index type too narrow for capacity");
+    static_assert(std::atomic<Index>::is_always_lock_free, "indices must be lock-free atomics");
+    return true;
+}
+
+/* single producer single consumer lock-free circular queue of compile-time capacity <N>. */
+/* the mask is a constant and elements are stored inline, so the queue can be embedded in another object or */
+/* placed in shared memory, and no operation loads the size or the storage pointer. */
+/* <Index> is the width of the indices: 64-bit never wraps in practice, narrower ones make tiny queues tinier. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: elements are constructed on push and destructed after the pop handle, those left with the queue. */
+template <typename T, size_t N, std::unsigned_integral Index = uint32_t>
+class StaticSpscQueue {
+    static_assert(validStaticCapacity<Index, N>());
+    static constexpr Index MASK = N - 1;
+
+  private:
+    // consumer's line: published read index and a cached copy of the write index
+    alignas(CACHELINE_SIZE) std::atomic<Index> head_ = 0;
+    Index tail_cache_ = 0;
+
+    // producer's line: published write index and a cached read index
+    alignas(CACHELINE_SIZE) std::atomic<Index> tail_ = 0;
+    Index head_cache_ = 0;
+
+    alignas(CACHELINE_SIZE) StaticStorage<T, N> slots_;
+
+    /* return the index to write to, or nothing if the queue is full now. */
+    std::optional<Index> acquire_w() noexcept {
+        Index tail = tail_.load(std::memory_order_relaxed);
+        if (static_cast<Index>(tail - head_cache_) == N) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (static_cast<Index>(tail - head_cache_) == N) return std::nullopt;
+        }
+        return tail;
+    }
+
+    /* return the index to read from, or nothing if the queue is empty now. */
+    std::optional<Index> acquire_r() noexcept {
+        Index head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return std::nullopt;
+        }
+        return head;
+    }
+
+  public:
+    StaticSpscQueue() = default;
+
+    ~StaticSpscQueue() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            Index tail = tail_.load(std::memory_order_relaxed);
+            for (Index i = head_.load(std::memory_order_relaxed); i != tail; i++) {
+                destroySlot(slots_[i & MASK]);
+            }
+        }
+    }
+
+    StaticSpscQueue(const StaticSpscQueue& other) = delete;
+    StaticSpscQueue& operator=(const StaticSpscQueue& other) = delete;
+
+    /* how many elements the queue holds at most. */
+    static constexpr size_t capacity() noexcept { return N; }
+
+    /* how many elements are waiting to be read, only a hint while others are using the queue. */
+    size_t size() const noexcept {
+        Index head = head_.load(std::memory_order_acquire);
+        return static_cast<Index>(tail_.load(std::memory_order_acquire) - head);
+    }
+
+    /* push an object to the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) noexcept requires RelatedTo<U, T> {
+        return emplace(std::forward<U>(obj));
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        std::optional<Index> idx = acquire_w();
+        if (!idx) return false;
+
+        T& slot = slots_[*idx & MASK];
+        initializeSlot(slot);
+        handle(slot);
+
+        tail_.store(static_cast<Index>(*idx + 1), std::memory_order_release);
+        return true;
+    }
+
+    /* directly construct an object at the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename... Args>
+    bool emplace(Args&&... args) noexcept {
+        std::optional<Index> idx = acquire_w();
+        if (!idx) return false;
+
+        constructSlot(slots_[*idx & MASK], std::forward<Args>(args)...);
+
+        tail_.store(static_cast<Index>(*idx + 1), std::memory_order_release);
+        return true;
+    }
+
+    /* pop an object from the front of the queue, and handle it with the callback user provides. */
+    /* return false if the queue is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        std::optional<Index> idx = acquire_r();
+        if (!idx) return false;
+
+        T& slot = slots_[*idx & MASK];
+        handle(slot);
+        destroySlot(slot);
+
+        head_.store(static_cast<Index>(*idx + 1), std::memory_order_release);
+        return true;
+    }
+
+    /* pop an object from the front of the queue and move it to <out>. */
+    /* return false if the queue is empty now, otherwise true. */
+    bool try_pop(T& out) noexcept {
+        return pop([&out](T& obj) { out = std::move(obj); });
+    }
+
+    /* pop an object from the front of the queue and move it out, return nothing if the queue is empty now. */
+    std::optional<T> try_pop() noexcept {
+        std::optional<T> out;
+        pop([&out](T& obj) { out.emplace(std::move(obj)); });
+        return out;
+    }
+};
+
+/* multiple producers multiple consumers lock-free circular queue of compile-time capacity <N>. */
+/* it takes places and elements in the same way as <MpmcUniqueQueue>, with a constant mask and inline storage. */
+/* NOTE: indices are claimed by CAS, so they must be wide enough never to come back to the same value while */
+/* a thread is preempted between loading and swapping one, which rules out indices narrower than 32 bits. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: elements are constructed on push and destructed after the pop handle, those left with the queue. */
+/* NOTE: failed CAS and ordered commits wait according to <Backoff> before trying again. */
+template <typename T, size_t N, std::unsigned_integral Index = uint32_t, BackoffPolicy Backoff = PauseBackoff>
+class StaticMpmcQueue {
+    static_assert(validStaticCapacity<Index, N>());
+    static_assert(sizeof(Index) >= sizeof(uint32_t), "narrow indices are exposed to ABA on CAS");
+    static constexpr Index MASK = N - 1;
+
+  private:
+    // each index lives on its own cache line so producers and consumers never share one
+    alignas(CACHELINE_SIZE) std::atomic<Index> next_w_ = 0;
+    alignas(CACHELINE_SIZE) std::atomic<Index> done_w_ = 0;
+    alignas(CACHELINE_SIZE) std::atomic<Index> next_r_ = 0;
+    alignas(CACHELINE_SIZE) std::atomic<Index> done_r_ = 0;
+
+    alignas(CACHELINE_SIZE) StaticStorage<T, N> slots_;
+
+    /* return the place acquired for writing, or nothing if the queue is full now. */
+    std::optional<Index> acquire_w() noexcept {
+        Index idx_w = next_w_.load(std::memory_order_acquire);
+        for (Backoff backoff;; backoff()) {
+            if (idx_w - done_r_.load(std::memory_order_acquire) == N) return std::nullopt;
+            if (next_w_.compare_exchange_weak(idx_w, idx_w + 1)) return idx_w;
+        }
+    }
+
+    /* mark the place <idx_w> has done after all the earlier writes. */
+    void commit_w(Index idx_w) noexcept {
+        for (Backoff backoff; done_w_.load(std::memory_order_acquire) != idx_w; backoff()) {}
+        done_w_.store(idx_w + 1, std::memory_order_release);
+    }
+
+    /* return the element locked down for reading, or nothing if the queue is empty now. */
+    std::optional<Index> acquire_r() noexcept {
+        Index idx_r = next_r_.load(std::memory_order_acquire);
+        for (Backoff backoff;; backoff()) {
+            if (idx_r == done_w_.load(std::memory_order_acquire)) return std::nullopt;
+            if (next_r_.compare_exchange_weak(idx_r, idx_r + 1)) return idx_r;
+        }
+    }
+
+    /* mark the element <idx_r> has done after all the earlier reads. */
+    void commit_r(Index idx_r) noexcept {
+        for (Backoff backoff; done_r_.load(std::memory_order_acquire) != idx_r; backoff()) {}
+        done_r_.store(idx_r + 1, std::memory_order_release);
+    }
+
+  public:
+    StaticMpmcQueue() = default;
+
+    ~StaticMpmcQueue() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            Index idx_w = done_w_.load(std::memory_order_relaxed);
+            for (Index i = done_r_.load(std::memory_order_relaxed); i != idx_w; i++) {
+                destroySlot(slots_[i & MASK]);
+            }
+        }
+    }
+
+    StaticMpmcQueue(const StaticMpmcQueue& other) = delete;
+    StaticMpmcQueue& operator=(const StaticMpmcQueue& other) = delete;
+
+    /* how many elements the queue holds at most. */
+    static constexpr size_t capacity() noexcept { return N; }
+
+    /* how many committed elements are not yet taken, only a hint while others are using the queue. */
+    size_t size() const noexcept {
+        // the read index never passes the write index, so reading it first keeps the difference non-negative
+        Index idx_r = next_r_.load(std::memory_order_acquire);
+        return done_w_.load(std::memory_order_acquire) - idx_r;
+    }
+
+    /* push an object to the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) noexcept requires RelatedTo<U, T> {
+        return emplace(std::forward<U>(obj));
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) noexcept requires Handle<F, T> {
+        std::optional<Index> idx_w = acquire_w();
+        if (!idx_w) return false;
+
+        T& slot = slots_[*idx_w & MASK];
+        initializeSlot(slot);
+        handle(slot);
+
+        commit_w(*idx_w);
+        return true;
+    }
+
+    /* directly construct an object at the end of the queue. */
+    /* return false if the queue is full now, otherwise true. */
+    template <typename... Args>
+    bool emplace(Args&&... args) noexcept {
+        std::optional<Index> idx_w = acquire_w();
+        if (!idx_w) return false;
+
+        constructSlot(slots_[*idx_w & MASK], std::forward<Args>(args)...);
+
+        commit_w(*idx_w);
+        return true;
+    }
+
+    /* pop an object from the front of the queue, and handle it with the callback user provides. */
+    /* return false if the queue is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        std::optional<Index> idx_r = acquire_r();
+        if (!idx_r) return false;
+
+        T& slot = slots_[*idx_r & MASK];
+        handle(slot);
+        destroySlot(slot);
+
+        commit_r(*idx_r);
+        return true;
+    }
+
+    /* pop an object from the front of the queue and move it to <out>. */
+    /* return false if the queue is empty now, otherwise true. */
+    bool try_pop(T& out) noexcept {
+        return pop([&out](T& obj) { out = std::move(obj); });
+    }
+
+    /* pop an object from the front of the queue and move it out, return nothing if the queue is empty now. */
+    std::optional<T> try_pop() noexcept {
+        std::optional<T> out;
+        pop([&out](T& obj) { out.emplace(std::move(obj)); });
+        return out;
+    }
+};
+
+}  // namespace lfcq
@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* events the statistics policy of a queue is told about. */
+enum class Stat : uint32_t {
+    PushAttempt,  // a push interface is called, each retry of a blocking push counts again
+    PushSuccess,  // a push interface returns with at least one element pushed
+    PopAttempt,   // a pop interface is called, each retry of a blocking pop counts again
+    PopSuccess,   // a pop interface returns with at least one element popped
+    Full,         // a push interface is rejected since the queue is full
+    Empty,        // a pop interface is rejected since the queue is empty
+    CasRetry,     // a compare-and-swap on one of the indices fails and has to be retried
+    CommitSpin,   // an iteration spent waiting for the earlier operations to commit in order
+    Signal,       // a push writes the event fd armed by the consumer
+    Count,
+};
+
+/* snapshot of the statistics of a queue, aggregated over all shards. */
+struct QueueStats {
+    uint64_t push_attempts = 0;
+    uint64_t push_successes = 0;
+    uint64_t pop_attempts = 0;
+    uint64_t pop_successes = 0;
+    uint64_t full_rejections = 0;
+    uint64_t empty_rejections = 0;
+    uint64_t cas_retries = 0;
+    uint64_t commit_spins = 0;
+    uint64_t event_signals = 0;
+    uint32_t high_watermark = 0;
+};
+
+/* default statistics policy, every hook is empty and compiles to nothing. */
+struct NoStats {
+    static constexpr bool enabled = false;
+
+    void count(Stat, uint64_t = 1) noexcept {}
+    void watermark(uint32_t) noexcept {}
+    QueueStats snapshot() const noexcept { return {}; }
+};
+
+/* statistics policy keeping its counters in <Shards> shards, each on its own cache lines. */
+/* a thread always updates the same shard, so the counters add no contention as long as */
+/* there are no more threads than shards, and <snapshot> sums all of them up. */
+template <uint32_t Shards = 16>
+class ShardedStats {
+  private:
+    struct alignas(CACHELINE_SIZE) Shard {
+        std::atomic<uint64_t> counters[static_cast<uint32_t>(Stat::Count)] = {};
+        std::atomic<uint32_t> watermark = 0;
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+
+    /* threads are assigned to shards in round robin on their first visit. */
+    static Shard& local(Shard* shards) noexcept {
+        static std::atomic<uint32_t> next = 0;
+        thread_local uint32_t idx = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+        return shards[idx];
+    }
+
+  public:
+    static constexpr bool enabled = true;
+
+    ShardedStats() : shards_(std::make_unique<Shard[]>(Shards)) {}
+
+    void count(Stat stat, uint64_t n = 1) noexcept {
+        local(shards_.get()).counters[static_cast<uint32_t>(stat)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void watermark(uint32_t occupancy) noexcept {
+        auto& mark = local(shards_.get()).watermark;
+        uint32_t cur = mark.load(std::memory_order_relaxed);
+        while (occupancy > cur && !mark.compare_exchange_weak(cur, occupancy, std::memory_order_relaxed)) {}
+    }
+
+    QueueStats snapshot() const noexcept {
+        uint64_t sums[static_cast<uint32_t>(Stat::Count)] = {};
+        uint32_t mark = 0;
+        for (uint32_t i = 0; i < Shards; i++) {
+            for (uint32_t j = 0; j < static_cast<uint32_t>(Stat::Count); j++) {
+                sums[j] += shards_[i].counters[j].load(std::memory_order_relaxed);
+            }
+            mark = std::max(mark, shards_[i].watermark.load(std::memory_order_relaxed));
+        }
+
+        QueueStats stats;
+        stats.push_attempts = sums[static_cast<uint32_t>(Stat::PushAttempt)];
+        stats.push_successes = sums[static_cast<uint32_t>(Stat::PushSuccess)];
+        stats.pop_attempts = sums[static_cast<uint32_t>(Stat::PopAttempt)];
+        stats.pop_successes = sums[static_cast<uint32_t>(Stat::PopSuccess)];
+        stats.full_rejections = sums[static_cast<uint32_t>(Stat::Full)];
+        stats.empty_rejections = sums[static_cast<uint32_t>(Stat::Empty)];
+        stats.cas_retries = sums[static_cast<uint32_t>(Stat::CasRetry)];
+        stats.commit_spins = sums[static_cast<uint32_t>(Stat::CommitSpin)];
+        stats.event_signals = sums[static_cast<uint32_t>(Stat::Signal)];
+        stats.high_watermark = mark;
+        return stats;
+    }
+};
+
+}  // namespace lfcq
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+
+namespace lfcq {
+
+/* move-only token lending one slot of <Queue> to a producer, obtained from <reserve>. */
+/* the slot is filled in place through the token and published by <commit>, or when the token is destroyed. */
+/* an empty token is returned if the queue is full, test it before use. */
+template <typename T, typename Queue>
+class WriteToken {
+  private:
+    friend Queue;
+
+    Queue* queue_ = nullptr;
+    T* slot_ = nullptr;
+    uint32_t idx_ = 0;
+
+    WriteToken(Queue* queue, T* slot, uint32_t idx) noexcept : queue_(queue), slot_(slot), idx_(idx) {}
+
+  public:
+    WriteToken() noexcept = default;
+    ~WriteToken() { commit(); }
+
+    WriteToken(const WriteToken& other) = delete;
+    WriteToken& operator=(const WriteToken& other) = delete;
+
+    WriteToken(WriteToken&& other) noexcept
+        : queue_(std::exchange(other.queue_, nullptr)), slot_(other.slot_), idx_(other.idx_) {}
+
+    WriteToken& operator=(WriteToken&& other) noexcept {
+        if (this != &other) {
+            commit();
+            queue_ = std::exchange(other.queue_, nullptr);
+            slot_ = other.slot_;
+            idx_ = other.idx_;
+        }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return queue_ != nullptr; }
+
+    T* get() const noexcept { return slot_; }
+    T& operator*() const noexcept { return *slot_; }
+    T* operator->() const noexcept { return slot_; }
+
+    /* publish the slot to the consumers, the token is empty afterwards. */
+    void commit() noexcept {
+        if (queue_) std::exchange(queue_, nullptr)->commit_token(idx_);
+    }
+};
+
+/* move-only token lending the front element of <Queue> to a consumer, obtained from <peek>. */
+/* the element is read in place through the token and handed back by <release>, or when the token is destroyed. */
+/* an empty token is returned if the queue is empty, test it before use. */
+template <typename T, typename Queue>
+class ReadToken {
+  private:
+    friend Queue;
+
+    Queue* queue_ = nullptr;
+    T* slot_ = nullptr;
+    uint32_t idx_ = 0;
+
+    ReadToken(Queue* queue, T* slot, uint32_t idx) noexcept : queue_(queue), slot_(slot), idx_(idx) {}
+
+  public:
+    ReadToken() noexcept = default;
+    ~ReadToken() { release(); }
+
+    ReadToken(const ReadToken& other) = delete;
+    ReadToken& operator=(const ReadToken& other) = delete;
+
+    ReadToken(ReadToken&& other) noexcept
+        : queue_(std::exchange(other.queue_, nullptr)), slot_(other.slot_), idx_(other.idx_) {}
+
+    ReadToken& operator=(ReadToken&& other) noexcept {
+        if (this != &other) {
+            release();
+            queue_ = std::exchange(other.queue_, nullptr);
+            slot_ = other.slot_;
+            idx_ = other.idx_;
+        }
+        return *this;
+    }
+
+    explicit operator bool() const noexcept { return queue_ != nullptr; }
+
+    T* get() const noexcept { return slot_; }
+    T& operator*() const noexcept { return *slot_; }
+    T* operator->() const noexcept { return slot_; }
+
+    /* hand the slot back to the producers, the token is empty afterwards. */
+    void release() noexcept {
+        if (queue_) std::exchange(queue_, nullptr)->release_token(idx_);
+    }
+};
+
+}  // namespace lfcq
@@ -0,0 +1,293 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include "basic_queue.hpp"
+#include "mpmc_sequence_queue.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* element of the unbounded queue, constructed on push and destructed on pop. */
+template <typename T>
+struct UnboundedSlot {
+    alignas(T) unsigned char data[sizeof(T)];
+    std::atomic<uint32_t> state;
+
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(data)); }
+};
+
+/* multiple producer multiple consumer lock-free queue without a capacity limit. */
+/* elements are kept in a linked list of ring segments, a new segment is linked when the last one fills up, */
+/* and a drained one is kept in a free list of <spare> segments for the next time, or released beyond that. */
+/* ONLY ONE consumer allowed to manipulate a certain element simultaneously. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: user can customize the memory allocator for the queue, which is rebound to the segments. */
+/* NOTE: push only fails by throwing the exception of the allocator when it needs a new segment. */
+template <typename T, typename Allocator = std::allocator<T>>
+class UnboundedQueue {
+  private:
+    using Slot = UnboundedSlot<T>;
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+
+    /* one ring of the list, the last position of each round is never written but marks the switch to the next. */
+    class Segment : public BasicQueue<Slot, SlotAllocator> {
+      public:
+        std::atomic<Segment*> next_;
+
+        Segment(uint32_t size, const SlotAllocator& alloc) : BasicQueue<Slot, SlotAllocator>(size, alloc) { reset(); }
+
+        Slot& operator[](uint32_t idx) noexcept { return this->queue_[idx]; }
+
+        /* forget about the last round, so the segment can be linked again. */
+        void reset() noexcept {
+            for (uint32_t i = 0; i < this->size_; i++) {
+                new (&this->queue_[i].state) std::atomic<uint32_t>(0);
+            }
+            next_.store(nullptr, std::memory_order_relaxed);
+        }
+    };
+    using SegmentAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Segment>;
+
+    // states of a slot
+    static constexpr uint32_t WRITE = 1;    // the element has been constructed
+    static constexpr uint32_t READ = 2;     // the element has been destructed
+    static constexpr uint32_t DESTROY = 4;  // the segment is left to the consumer of this slot to recycle
+
+    // indices count positions from bit <SHIFT>, the lowest bit of the head tells whether the head segment
+    // has a successor, so consumers need not check the tail
+    static constexpr uint32_t SHIFT = 1;
+    static constexpr uint64_t HAS_NEXT = 1;
+
+    struct alignas(CACHELINE_SIZE) Position {
+        std::atomic<uint64_t> index;
+        std::atomic<Segment*> segment;
+    };
+
+    Position head_;
+    Position tail_;
+
+    uint32_t lap_;  // positions in a round of a segment, one more than the elements it holds
+    SlotAllocator slot_alloc_;
+    SegmentAllocator segment_alloc_;
+    std::optional<MpmcSequenceQueue<Segment*>> spare_;  // none if no drained segment is kept
+
+    /* take a segment from the free list, or allocate a new one if it is empty. */
+    Segment* obtain() {
+        Segment* segment = nullptr;
+        if (spare_ && spare_->pop([&segment](Segment*& ptr) { segment = ptr; })) return segment;
+
+        segment = segment_alloc_.allocate(1);
+        return new (segment) Segment(lap_, slot_alloc_);
+    }
+
+    /* put a segment no one refers to any more back to the free list, or release it if the list is full. */
+    void recycle(Segment* segment) noexcept {
+        segment->reset();
+        if (spare_ && spare_->push(segment)) return;
+
+        segment->~Segment();
+        segment_alloc_.deallocate(segment, 1);
+    }
+
+    /* recycle the segment once the elements from <start> on are all read. */
+    /* a consumer still reading one of them is left to carry on from the next one after it. */
+    void destroy(Segment* segment, uint32_t start) noexcept {
+        for (uint32_t i = start; i < lap_ - 2; i++) {
+            auto& state = (*segment)[i].state;
+            if ((state.load(std::memory_order_acquire) & READ) == 0 &&
+                (state.fetch_or(DESTROY, std::memory_order_acq_rel) & READ) == 0) {
+                return;
+            }
+        }
+        recycle(segment);
+    }
+
+    /* acquire the next position for writing and construct the element there with <init>. */
+    template <typename F>
+    void write(F&& init) {
+        uint64_t tail = tail_.index.load(std::memory_order_acquire);
+        Segment* segment = tail_.segment.load(std::memory_order_acquire);
+        Segment* next = nullptr;
+
+        while (true) {
+            uint32_t offset = (tail >> SHIFT) & (lap_ - 1);
+
+            // another producer is linking the next segment
+            if (offset == lap_ - 1) {
+                cpuRelax();
+                tail = tail_.index.load(std::memory_order_acquire);
+                segment = tail_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // prepare the next segment before taking the last position, so linking it never waits
+            if (offset + 2 == lap_ && next == nullptr) next = obtain();
+
+            uint64_t new_tail = tail + (1 << SHIFT);
+            if (!tail_.index.compare_exchange_weak(tail, new_tail, std::memory_order_seq_cst,
+                                                   std::memory_order_acquire)) {
+                segment = tail_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // the last position is ours, link the next segment and skip the marker position
+            if (offset + 2 == lap_) {
+                tail_.segment.store(next, std::memory_order_release);
+                tail_.index.store(new_tail + (1 << SHIFT), std::memory_order_release);
+                segment->next_.store(std::exchange(next, nullptr), std::memory_order_release);
+            }
+
+            Slot& slot = (*segment)[offset];
+            init(slot.data);
+            slot.state.fetch_or(WRITE, std::memory_order_release);
+
+            if (next) recycle(next);
+            return;
+        }
+    }
+
+  public:
+    /* construct a queue linking segments of <size> elements at least, and keeping <spare> drained ones. */
+    /* NOTE: with <spare> 0 every drained segment is released, otherwise at least 2 of them are kept. */
+    UnboundedQueue(uint32_t size = 1024, uint32_t spare = 4, const Allocator& alloc = Allocator())
+        : lap_(alignUpPowOf2(std::max(size + 1, 4U))), slot_alloc_(alloc), segment_alloc_(alloc) {
+        if (spare != 0) spare_.emplace(std::max(spare, 2U));
+        Segment* segment = obtain();
+        head_.index = 0;
+        head_.segment = segment;
+        tail_.index = 0;
+        tail_.segment = segment;
+    }
+
+    ~UnboundedQueue() {
+        // destruct the elements left, releasing every segment on the way
+        while (pop([](T&) {})) {}
+
+        Segment* segment = head_.segment.load(std::memory_order_relaxed);
+        segment->~Segment();
+        segment_alloc_.deallocate(segment, 1);
+
+        while (spare_ && spare_->pop([&segment](Segment*& ptr) { segment = ptr; })) {
+            segment->~Segment();
+            segment_alloc_.deallocate(segment, 1);
+        }
+    }
+
+    UnboundedQueue(const UnboundedQueue& other) = delete;
+    UnboundedQueue& operator=(const UnboundedQueue& other) = delete;
+
+    /* push an object to the end of the queue. */
+    /* always return true. */
+    template <typename U>
+    bool push(U&& obj) requires RelatedTo<U, T> {
+        write([&obj](void* dst) { new (dst) T(std::forward<U>(obj)); });
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object. */
+    /* the object is default constructed before the callback is applied to it. */
+    /* always return true. */
+    template <typename F>
+    bool push(F&& handle) requires Handle<F, T> && std::default_initializable<T> {
+        write([&handle](void* dst) { handle(*new (dst) T()); });
+        return true;
+    }
+
+    /* directly construct an object at the end of the queue. */
+    /* always return true. */
+    template <typename... Args>
+    bool emplace(Args&&... args) {
+        write([&args...](void* dst) { new (dst) T(std::forward<Args>(args)...); });
+        return true;
+    }
+
+    /* pop an object from the front of the queue, handle it with the callback user provides, then destruct it. */
+    /* return false if the queue is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        uint64_t head = head_.index.load(std::memory_order_acquire);
+        Segment* segment = head_.segment.load(std::memory_order_acquire);
+
+        while (true) {
+            uint32_t offset = (head >> SHIFT) & (lap_ - 1);
+
+            // another consumer is moving on to the next segment
+            if (offset == lap_ - 1) {
+                cpuRelax();
+                head = head_.index.load(std::memory_order_acquire);
+                segment = head_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            uint64_t new_head = head + (1 << SHIFT);
+            if ((new_head & HAS_NEXT) == 0) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                uint64_t tail = tail_.index.load(std::memory_order_relaxed);
+                if ((head >> SHIFT) == (tail >> SHIFT)) return false;
+
+                // the tail has gone beyond this segment, so it has a successor
+                if ((head >> SHIFT) / lap_ != (tail >> SHIFT) / lap_) new_head |= HAS_NEXT;
+            }
+
+            if (!head_.index.compare_exchange_weak(head, new_head, std::memory_order_seq_cst,
+                                                   std::memory_order_acquire)) {
+                segment = head_.segment.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // the last element is ours, move the head on to the next segment and skip the marker position
+            if (offset + 2 == lap_) {
+                Segment* next;
+                while ((next = segment->next_.load(std::memory_order_acquire)) == nullptr) {
+                    cpuRelax();
+                }
+                uint64_t next_head = (new_head & ~HAS_NEXT) + (1 << SHIFT);
+                if (next->next_.load(std::memory_order_relaxed) != nullptr) next_head |= HAS_NEXT;
+
+                head_.segment.store(next, std::memory_order_release);
+                head_.index.store(next_head, std::memory_order_release);
+            }
+
+            // the producer may not have finished constructing it
+            Slot& slot = (*segment)[offset];
+            while ((slot.state.load(std::memory_order_acquire) & WRITE) == 0) {
+                cpuRelax();
+            }
+
+            T* obj = slot.get();
+            handle(*obj);
+            obj->~T();
+
+            // the consumer of the last element starts recycling, and a pending one is continued by us
+            if (offset + 2 == lap_) {
+                destroy(segment, 0);
+            } else if (slot.state.fetch_or(READ, std::memory_order_acq_rel) & DESTROY) {
+                destroy(segment, offset + 1);
+            }
+            return true;
+        }
+    }
+
+    /* pop an object from the front of the queue and move it to <out>. */
+    /* return false if the queue is empty now, otherwise true. */
+    bool try_pop(T& out) noexcept {
+        return pop([&out](T& obj) { out = std::move(obj); });
+    }
+
+    /* pop an object from the front of the queue and move it out, return nothing if the queue is empty now. */
+    std::optional<T> try_pop() noexcept {
+        std::optional<T> out;
+        pop([&out](T& obj) { out.emplace(std::move(obj)); });
+        return out;
+    }
+
+    /* compatible interface for type-erased pop handle, prefer the templated one. */
+    bool pop(PopHandle<T>&& handle) noexcept { return pop<PopHandle<T>&>(handle); }
+};
+
+}  // namespace lfcq
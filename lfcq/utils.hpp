@@ -1,12 +1,15 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
-#ifndef NDEBUG
-#include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <iterator>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
 #endif
 
 namespace lfcq {
@@ -30,46 +33,88 @@ inline uint32_t alignUpPowOf2(uint32_t val) {
 
 #undef QUEUE_MAX_SIZE
 
+/* size of the cache line that indices modified by different threads are isolated by. */
+/* NOTE: define LFCQ_CACHELINE_SIZE to match the target, e.g. 128 where adjacent lines are prefetched in pairs. */
+#ifndef LFCQ_CACHELINE_SIZE
+#define LFCQ_CACHELINE_SIZE 64
+#endif
+inline constexpr size_t CACHELINE_SIZE = LFCQ_CACHELINE_SIZE;
+
+/* hint the CPU that we are spinning, which saves power and leaves the pipeline to the sibling hyperthread. */
+inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/* how bulk interfaces copy trivially copyable elements into the ring. */
+enum class CopyMode {
+    Regular,    // memcpy, the copied lines stay in the cache of the writer
+    Streaming,  // non-temporal stores which bypass the cache, for large payloads the writer won't read again
+};
+
+/* copy <n> bytes from <src> to <dst> according to <Mode>. */
+/* NOTE: streaming stores are weakly ordered, call <storeFence> before publishing what they wrote. */
+template <CopyMode Mode>
+inline void copyBytes(void* dst, const void* src, size_t n) noexcept {
+#if defined(__SSE2__)
+    if constexpr (Mode == CopyMode::Streaming) {
+        auto d = static_cast<char*>(dst);
+        auto s = static_cast<const char*>(src);
+
+        // only the 16-byte aligned middle part can be streamed, the ragged ends are copied as usual
+        size_t head = std::min(n, (16 - reinterpret_cast<uintptr_t>(d) % 16) % 16);
+        std::memcpy(d, s, head);
+        d += head, s += head, n -= head;
+        for (; n >= 16; d += 16, s += 16, n -= 16) {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+        }
+        std::memcpy(d, s, n);
+        return;
+    }
+#endif
+    std::memcpy(dst, src, n);
+}
+
+/* order the streaming stores before any later store, such as the one publishing the written elements. */
+inline void storeFence() noexcept {
+#if defined(__SSE2__)
+    _mm_sfence();
+#else
+    std::atomic_thread_fence(std::memory_order_release);
+#endif
+}
+
+/* iterators over contiguous trivially copyable elements of T, which bulk interfaces copy with <copyBytes>. */
+template <typename It, typename T>
+concept Memcpyable =
+    std::contiguous_iterator<It> && std::same_as<std::iter_value_t<It>, T> && std::is_trivially_copyable_v<T>;
+
 /* automatically generate <push> function for derivative types of T. */
 template <typename U, typename T>
 concept RelatedTo = std::same_as<U, T> || std::same_as<U, const T> || std::same_as<U, T&> || std::same_as<U, const T&>;
 
+/* any callable that can handle an element in place, accepted by templated interfaces so it can be inlined. */
+template <typename F, typename T>
+concept Handle = std::invocable<F, T&> && !RelatedTo<F, T>;
+
 /* callback when the user wishes to manually assign to some members of the object */
+/* NOTE: kept for compatibility, type erasure prevents inlining and may allocate. */
 template <typename T>
 using PushHandle = std::function<void(T&)>;
 
 /* callback when there is an element popped from the queue. */
+/* NOTE: kept for compatibility, type erasure prevents inlining and may allocate. */
 template <typename T>
 using PopHandle = std::function<void(T&)>;
 
 /* cache-friendly wrapper for user's data structure. */
 template <typename T>
-struct alignas(64) Aligned {
+struct alignas(CACHELINE_SIZE) Aligned {
     T data;
-    static_assert(alignof(Aligned<T>) == 64);
+    static_assert(alignof(Aligned<T>) == CACHELINE_SIZE);
 };
 
-#ifndef NDEBUG
-/* an encapsulation for easier management on file stream. */
-class Dumper {
-  private:
-    std::ofstream file_;
-
-  public:
-    explicit Dumper(const std::string&& path) : file_(std::filesystem::path(path)) {
-        if (!file_) {
-            std::cout << "[Dumper] fail to open or create dump file: " << path << std::endl;
-            exit(1);
-        }
-    }
-
-    ~Dumper() { file_.close(); }
-
-    template <typename... Args>
-    void dump(Args&&... args) {
-        (file_ << ... << std::forward<Args>(args)) << std::endl;
-    }
-};
-#endif
-
 }  // namespace lfcq
@@ -0,0 +1,257 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* how a blocking interface escalates while the queue is not ready for it: */
+/* busy spin -> spin with pause -> yield the CPU -> sleep until the opposite side notifies. */
+struct WaitPolicy {
+    uint32_t spin = 64;
+    uint32_t pause = 512;
+    uint32_t yield = 16;
+};
+
+/* a coroutine suspended on one side of a queue, linked into <Parking> until the opposite side notifies. */
+/* whoever unlinks the node calls <wake> exactly once, which may link it again. */
+struct AwaitNode {
+    AwaitNode* next = nullptr;
+    void (*wake)(AwaitNode* node) noexcept = nullptr;
+};
+
+/* room for threads sleeping on one side of a queue, the index of the opposite side serves as the futex word, */
+/* for coroutines suspended there, which are kept in a lock-free list, and for an event fd armed by a thread */
+/* which watches it in an event loop instead. */
+/* NOTE: the opposite side must publish its index with a seq_cst operation before calling <notify>. */
+/* NOTE: notification costs two loads of the same line when nobody is sleeping. */
+class Parking {
+  private:
+    // set in <waiters_> while the event fd is armed, which keeps the notification down to a single check
+    static constexpr uint32_t ARMED = 1U << 31;
+
+    std::atomic<uint32_t> waiters_ = 0;
+    std::atomic<AwaitNode*> awaiters_ = nullptr;
+    std::atomic<int> event_fd_ = -1;
+    std::atomic<uint32_t> signals_ = 0;  // how many times the event fd has been written
+
+    // kept by the arming thread: whether its arm may still be set, how many of its arms notifiers have taken,
+    // and how many of their writes it has read
+    bool armed_ = false;
+    uint32_t taken_ = 0;
+    uint32_t seen_ = 0;
+
+    /* take the arm back, and count it as taken by a notifier if it is gone already. */
+    void disarm() noexcept {
+        if ((waiters_.fetch_and(~ARMED, std::memory_order_relaxed) & ARMED) == 0) taken_++;
+        armed_ = false;
+    }
+
+    /* write the event fd if it is still armed, return whether it was. */
+    bool signal() noexcept {
+#ifdef __linux__
+        if ((waiters_.fetch_and(~ARMED, std::memory_order_seq_cst) & ARMED) == 0) return false;
+        eventfd_write(event_fd_.load(std::memory_order_relaxed), 1);
+        // counted after the write, so the arming thread never takes the count for a write not yet done
+        signals_.fetch_add(1, std::memory_order_release);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /* sleep until <word> is no longer <old>, or the relative <timeout> expires if it is given. */
+    static void sleep(std::atomic<uint32_t>& word, uint32_t old, const timespec* timeout) noexcept {
+#ifdef __linux__
+        syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, old, timeout, nullptr, 0);
+#else
+        // without futex timed waits keep yielding instead of sleeping
+        if (timeout == nullptr) {
+            word.wait(old);
+        } else {
+            std::this_thread::yield();
+        }
+#endif
+    }
+
+    /* wake all the threads sleeping on <word>. */
+    static void wake(std::atomic<uint32_t>& word) noexcept {
+#ifdef __linux__
+        syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+        word.notify_all();
+#endif
+    }
+
+  public:
+    Parking() = default;
+
+    ~Parking() {
+#ifdef __linux__
+        int fd = event_fd_.load(std::memory_order_relaxed);
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    Parking(const Parking& other) = delete;
+    Parking& operator=(const Parking& other) = delete;
+
+    /* whether any thread is sleeping or about to sleep here. */
+    bool waiting() const noexcept { return (waiters_.load(std::memory_order_seq_cst) & ~ARMED) != 0; }
+
+    /* wake the sleeping threads, the suspended coroutines and the armed event fd after <word> has been changed, */
+    /* if there is any. */
+    /* return whether the event fd was written. */
+    bool notify(std::atomic<uint32_t>& word) noexcept {
+        bool signalled = false;
+        if (uint32_t waiters = waiters_.load(std::memory_order_seq_cst); waiters != 0) [[unlikely]] {
+            if ((waiters & ~ARMED) != 0) wake(word);
+            if ((waiters & ARMED) != 0) signalled = signal();
+        }
+        if (awaiters_.load(std::memory_order_seq_cst) != nullptr) [[unlikely]] {
+            wake_awaiters();
+        }
+        return signalled;
+    }
+
+#ifdef __linux__
+    /* the event fd, which is created on the first call, and throws if it can not be. */
+    int event_fd() {
+        int fd = event_fd_.load(std::memory_order_acquire);
+        if (fd >= 0) return fd;
+
+        int created = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (created < 0) throw std::system_error(errno, std::generic_category(), "eventfd");
+        if (!event_fd_.compare_exchange_strong(fd, created, std::memory_order_acq_rel)) {
+            // another thread got there first
+            close(created);
+            return fd;
+        }
+        return created;
+    }
+
+    /* arm the event fd, to be written by the next notification, unless <ready> tells there is no need to. */
+    /* the writes of the notifiers which took the earlier arms are read first, so the fd is readable again */
+    /* only after a later notification, and is never read when nobody has written it. */
+    /* return false if <ready> is true after arming, in which case the fd is left unarmed. */
+    /* NOTE: only one thread at a time arms the fd. */
+    template <typename Ready>
+    bool arm(Ready&& ready) {
+        int fd = event_fd();
+        if (armed_) disarm();
+
+        if (taken_ != seen_) {
+            // a notifier counts its write right after making it, which must not be read before it is made
+            while (signals_.load(std::memory_order_acquire) != taken_) {
+                std::this_thread::yield();
+            }
+            eventfd_t cnt;
+            eventfd_read(fd, &cnt);
+            seen_ = taken_;
+        }
+
+        // either we see the change of the opposite side, or it sees the fd armed
+        waiters_.fetch_or(ARMED, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        armed_ = true;
+        if (!ready()) return true;
+
+        disarm();
+        return false;
+    }
+#endif
+
+    /* link <node> to be woken by the next notification. */
+    /* NOTE: seq_cst so a waker checking the queue afterwards either sees the change or gets <node> woken. */
+    void enlist(AwaitNode* node) noexcept {
+        AwaitNode* head = awaiters_.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!awaiters_.compare_exchange_weak(head, node, std::memory_order_seq_cst, std::memory_order_relaxed));
+    }
+
+    /* unlink every linked node at once and wake each of them, last linked first, except <self>. */
+    /* return whether <self> was among them, otherwise someone else has unlinked it and is waking it. */
+    /* NOTE: taking the whole list by one exchange leaves no room for ABA, whatever is linked again meanwhile. */
+    bool wake_awaiters(const AwaitNode* self = nullptr) noexcept {
+        AwaitNode* node = awaiters_.exchange(nullptr, std::memory_order_acq_rel);
+        bool found = false;
+        while (node != nullptr) {
+            // a woken node may be linked again, or be gone with its coroutine
+            AwaitNode* next = node->next;
+            if (node == self) {
+                found = true;
+            } else {
+                node->wake(node);
+            }
+            node = next;
+        }
+        return found;
+    }
+
+    /* retry <op> until it succeeds or <deadline> is reached, sleep on <word> after escalating through <policy>. */
+    /* return false if <deadline> is reached before <op> succeeds, otherwise true. */
+    template <typename Op, typename Clock, typename Duration>
+    bool wait(std::atomic<uint32_t>& word, Op&& op, const std::chrono::time_point<Clock, Duration>& deadline,
+              const WaitPolicy& policy) noexcept {
+        constexpr auto forever = std::chrono::time_point<Clock, Duration>::max();
+
+        for (uint32_t round = 0; !op(); round++) {
+            if (round < policy.spin) continue;
+            if (deadline != forever && Clock::now() >= deadline) return false;
+
+            if (round < policy.spin + policy.pause) {
+                cpuRelax();
+            } else if (round < policy.spin + policy.pause + policy.yield) {
+                std::this_thread::yield();
+            } else {
+                // register before reading the word, so either we see the change or the notifier sees us
+                waiters_.fetch_add(1, std::memory_order_seq_cst);
+                uint32_t old = word.load(std::memory_order_seq_cst);
+                bool done = op();
+
+                if (!done && deadline == forever) {
+                    sleep(word, old, nullptr);
+                } else if (!done) {
+                    auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+                    if (remaining.count() > 0) {
+                        timespec timeout{static_cast<time_t>(remaining.count() / 1'000'000'000),
+                                         static_cast<long>(remaining.count() % 1'000'000'000)};
+                        sleep(word, old, &timeout);
+                    }
+                }
+
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                if (done) return true;
+            }
+        }
+        return true;
+    }
+
+    /* retry <op> until it succeeds, sleep on <word> after escalating through <policy>. */
+    template <typename Op>
+    void wait(std::atomic<uint32_t>& word, Op&& op, const WaitPolicy& policy) noexcept {
+        wait(word, std::forward<Op>(op), std::chrono::steady_clock::time_point::max(), policy);
+    }
+};
+
+/* what a queue built without blocking interfaces keeps instead of <Parking>, which takes no room. */
+struct NoParking {};
+
+/* the parking of one side of a queue, which exists only if the queue is <Waitable>. */
+template <bool Waitable>
+using ParkingOf = std::conditional_t<Waitable, Parking, NoParking>;
+
+}  // namespace lfcq
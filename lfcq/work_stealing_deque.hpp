@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "basic_queue.hpp"
+#include "utils.hpp"
+
+namespace lfcq {
+
+/* Chase-Lev work-stealing deque, with the memory orderings of Le et al. for weak memory models. */
+/* ONE owner pushes and pops at the bottom in LIFO order without any atomic read-modify-write on the fast path, */
+/* while any number of thieves steal from the top in FIFO order with a CAS, which only races the owner for the */
+/* last element. */
+/* the ring doubles when the owner finds it full, unless growth is disabled, and rings outgrown are retired */
+/* rather than freed since thieves may still be reading them, until the deque is destructed. */
+/* NOTE: neither copyable nor movable. */
+/* NOTE: all callbacks provided by user are forbidden to throw exception. */
+/* NOTE: user can customize the memory allocator for the rings. */
+/* NOTE: T must be trivially copyable, a thief copies an element out before its CAS decides who takes it. */
+template <typename T, typename Allocator = std::allocator<T>>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "work-stealing deque requires trivially copyable elements");
+
+  private:
+    /* power-of-two storage indexed by the ever-increasing positions of the deque. */
+    class Ring : public BasicQueue<T, Allocator> {
+      public:
+        Ring(uint32_t size, const Allocator& alloc) : BasicQueue<T, Allocator>(size, alloc) {}
+
+        int64_t capacity() const noexcept { return this->size_; }
+
+        /* the element at <pos> is read by thieves while the owner may write it, so it is accessed atomically */
+        /* whenever T fits into a lock-free atomic. */
+        T load(int64_t pos) const noexcept {
+            T& slot = this->queue_[pos & this->mask_];
+            if constexpr (std::atomic_ref<T>::is_always_lock_free) {
+                return std::atomic_ref<T>(slot).load(std::memory_order_relaxed);
+            } else {
+                return slot;
+            }
+        }
+
+        void store(int64_t pos, const T& obj) noexcept {
+            T& slot = this->queue_[pos & this->mask_];
+            if constexpr (std::atomic_ref<T>::is_always_lock_free) {
+                std::atomic_ref<T>(slot).store(obj, std::memory_order_relaxed);
+            } else {
+                slot = obj;
+            }
+        }
+    };
+
+    // positions are signed, so the owner may take <bottom_> one below <top_> while it pops
+    alignas(CACHELINE_SIZE) std::atomic<int64_t> top_;
+    alignas(CACHELINE_SIZE) std::atomic<int64_t> bottom_;
+    alignas(CACHELINE_SIZE) std::atomic<Ring*> ring_;
+    Allocator alloc_;
+    bool grow_;
+    std::vector<std::unique_ptr<Ring>> rings_;  // the current ring and every ring retired, owned by the owner
+
+    /* move the elements in [top, bottom) to a ring of twice the size, return nullptr if it is already maximum. */
+    Ring* grow(Ring* ring, int64_t top, int64_t bottom) {
+        if (ring->capacity() >= alignUpPowOf2(UINT32_MAX)) return nullptr;
+
+        auto bigger = std::make_unique<Ring>(ring->capacity() * 2, alloc_);
+        for (int64_t pos = top; pos < bottom; pos++) {
+            bigger->store(pos, ring->load(pos));
+        }
+
+        ring = bigger.get();
+        rings_.push_back(std::move(bigger));
+        ring_.store(ring, std::memory_order_release);
+        return ring;
+    }
+
+  public:
+    /* construct a deque of at least <size> elements, which doubles on demand if <grow> is true. */
+    explicit WorkStealingDeque(uint32_t size, bool grow = true, const Allocator& alloc = Allocator())
+        : top_(0), bottom_(0), alloc_(alloc), grow_(grow) {
+        rings_.push_back(std::make_unique<Ring>(size, alloc_));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque& other) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+    /* push an object to the bottom, called by the owner only. */
+    /* NOTE: growing allocates a new ring, which throws if the allocator does. */
+    /* return false if the deque is full and may not grow, otherwise true. */
+    template <typename U>
+    bool push(U&& obj) requires RelatedTo<U, T> {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+
+        if (bottom - top >= ring->capacity()) {
+            if (!grow_ || (ring = grow(ring, top, bottom)) == nullptr) return false;
+        }
+
+        ring->store(bottom, obj);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* call this push interface when you wish to manually initialize the object, called by the owner only. */
+    /* return false if the deque is full and may not grow, otherwise true. */
+    template <typename F>
+    bool push(F&& handle) requires Handle<F, T> && std::default_initializable<T> {
+        T obj;
+        handle(obj);
+        return push(obj);
+    }
+
+    /* pop the object pushed last and handle it with the callback user provides, called by the owner only. */
+    /* return false if the deque is empty now, otherwise true. */
+    template <typename F>
+    bool pop(F&& handle) noexcept requires Handle<F, T> {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+
+        // claim the bottom first, then see whether thieves got there as well
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        T obj = ring->load(bottom);
+        if (top == bottom) {
+            // the last element, race the thieves for it like one of them
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            if (!won) return false;
+        }
+
+        handle(obj);
+        return true;
+    }
+
+    /* steal the object pushed first and handle it with the callback user provides, called by any thief. */
+    /* return false if the deque is empty now or another thread took the element first, otherwise true. */
+    template <typename F>
+    bool steal(F&& handle) noexcept requires Handle<F, T> {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) return false;
+
+        // the copy is only ours if nobody moves <top_> in between
+        T obj = ring_.load(std::memory_order_acquire)->load(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+
+        handle(obj);
+        return true;
+    }
+
+    /* how many elements there are, only a hint while others are using the deque. */
+    uint32_t size() const noexcept {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<uint32_t>(bottom - top) : 0;
+    }
+
+    /* how many elements the current ring holds. */
+    uint32_t capacity() const noexcept {
+        return static_cast<uint32_t>(ring_.load(std::memory_order_relaxed)->capacity());
+    }
+};
+
+}  // namespace lfcq
@@ -1,6 +1,18 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
 
+#include "backoff.hpp"
 #include "basic_queue.hpp"
+#include "huge_page_allocator.hpp"
+#include "mpmc_sequence_queue.hpp"
+#include "mpmc_shared_queue.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "static_queue.hpp"
+#include "stats.hpp"
 #include "tools.hpp"
 #include "types.hpp"
 #include "utils.hpp"
@@ -33,6 +45,270 @@ TYPED_TEST(BasicTest, AllocatorTest) {
     EXPECT_EQ(*(this->allocator_.dealloc_n), alignUpPowOf2(this->size_));
 }
 
+TYPED_TEST(BasicTest, StatsTest) {
+    using Stats = ShardedStats<4>;
+
+    // fill the queue up and drain it, with one rejection on each side
+    auto exercise = [](auto& queue, uint32_t size) {
+        for (uint32_t i = 0; i < size; i++) {
+            EXPECT_TRUE(queue.push(TypeParam{0, i}));
+        }
+        EXPECT_FALSE(queue.push(TypeParam{0, size}));
+        for (uint32_t i = 0; i < size; i++) {
+            EXPECT_TRUE(queue.pop([](TypeParam&) {}));
+        }
+        EXPECT_FALSE(queue.pop([](TypeParam&) {}));
+
+        QueueStats stats = queue.stats();
+        EXPECT_EQ(stats.push_attempts, size + 1);
+        EXPECT_EQ(stats.push_successes, size);
+        EXPECT_EQ(stats.full_rejections, 1);
+        EXPECT_EQ(stats.pop_attempts, size + 1);
+        EXPECT_EQ(stats.pop_successes, size);
+        EXPECT_EQ(stats.empty_rejections, 1);
+        EXPECT_EQ(stats.cas_retries, 0);
+        EXPECT_EQ(stats.high_watermark, size);
+    };
+
+    uint32_t size = alignUpPowOf2(this->size_);
+    SpscQueue<TypeParam, std::allocator<TypeParam>, Stats> spsc(this->size_);
+    exercise(spsc, size);
+    MpmcUniqueQueue<TypeParam, std::allocator<TypeParam>, Stats> unique(this->size_);
+    exercise(unique, size);
+    MpmcSequenceQueue<TypeParam, std::allocator<TypeParam>, Stats> sequence(this->size_);
+    exercise(sequence, size);
+
+    // nothing is collected by default
+    SpscQueue<TypeParam> plain(this->size_);
+    EXPECT_TRUE(plain.push(TypeParam{0, 0}));
+    EXPECT_EQ(plain.stats().push_attempts, 0);
+}
+
+TYPED_TEST(BasicTest, HugePageAllocatorTest) {
+    // a huge page is not guaranteed here, the allocator must fall back to normal pages then
+    HugePageOptions options;
+    options.lock = true;
+    SpscQueue<TypeParam, HugePageAllocator<TypeParam>> spsc(this->size_, HugePageAllocator<TypeParam>(options));
+    for (uint32_t i = 0; i < alignUpPowOf2(this->size_); i++) {
+        EXPECT_TRUE(spsc.push(TypeParam{0, i}));
+    }
+    for (uint32_t i = 0; i < alignUpPowOf2(this->size_); i++) {
+        EXPECT_TRUE(spsc.pop([i](TypeParam& obj) { EXPECT_EQ(obj.seq, i); }));
+    }
+
+    // the allocator is rebound to the slot type
+    MpmcSequenceQueue<TypeParam, HugePageAllocator<TypeParam>> sequence(this->size_);
+    EXPECT_TRUE(sequence.push(TypeParam{0, 1}));
+    EXPECT_TRUE(sequence.pop([](TypeParam& obj) { EXPECT_EQ(obj.seq, 1); }));
+}
+
+template <typename Backoff>
+class BackoffTest : public testing::Test {};
+
+using BackoffTypes = testing::Types<NoBackoff, PauseBackoff, ExponentialBackoff<16>, YieldBackoff<4>>;
+TYPED_TEST_SUITE(BackoffTest, BackoffTypes);
+
+// contended CAS loops and ordered commits go through every policy, more threads than cores here
+TYPED_TEST(BackoffTest, ContentionTest) {
+    constexpr uint32_t threads = 3, per_thread = 5000;
+    auto exercise = [](auto& queue) {
+        std::atomic<uint64_t> w_sum = 0, r_sum = 0;
+        std::vector<std::thread> workers;
+        for (uint32_t i = 0; i < threads; i++) {
+            workers.emplace_back([&, i]() {
+                for (uint32_t j = 0; j < per_thread; j++) {
+                    while (!queue.push(TrivialObj{i, j})) {
+                        std::this_thread::yield();
+                    }
+                    w_sum += j;
+                }
+            });
+            workers.emplace_back([&]() {
+                for (uint32_t j = 0; j < per_thread;) {
+                    if (queue.pop([&](TrivialObj& obj) { r_sum += obj.seq; })) {
+                        j++;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        EXPECT_EQ(w_sum, r_sum);
+    };
+
+    MpmcUniqueQueue<TrivialObj, std::allocator<TrivialObj>, NoStats, TypeParam> unique(16);
+    exercise(unique);
+    MpmcSequenceQueue<TrivialObj, std::allocator<TrivialObj>, NoStats, TypeParam> sequence(16);
+    exercise(sequence);
+    StaticMpmcQueue<TrivialObj, 16, uint32_t, TypeParam> fixed;
+    exercise(fixed);
+}
+
+/* element owning heap memory, counting how many of it are alive and how many deep copies were made. */
+struct Tracked {
+    static inline int64_t alive = 0;
+    static inline int64_t copies = 0;
+
+    std::string payload;
+
+    explicit Tracked(std::string _payload) : payload(std::move(_payload)) { alive++; }
+    Tracked(const Tracked& other) : payload(other.payload) { alive++, copies++; }
+    Tracked(Tracked&& other) noexcept : payload(std::move(other.payload)) { alive++; }
+    Tracked& operator=(const Tracked& other) = delete;
+    Tracked& operator=(Tracked&& other) noexcept = default;
+    ~Tracked() { alive--; }
+};
+
+/* a queue template to be instantiated with different elements. */
+template <template <typename...> class Queue>
+struct QueueOf {
+    template <typename T>
+    using type = Queue<T>;
+};
+
+template <typename Q>
+class LifetimeTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        Tracked::alive = 0;
+        Tracked::copies = 0;
+    }
+};
+
+// the queues with a non-type parameter are passed through aliases of their defaults
+template <typename T>
+using DefaultSpscQueue = SpscQueue<T>;
+template <typename T>
+using DefaultMpmcUniqueQueue = MpmcUniqueQueue<T>;
+
+using QueueTypes =
+    testing::Types<QueueOf<DefaultSpscQueue>, QueueOf<DefaultMpmcUniqueQueue>, QueueOf<MpmcSequenceQueue>>;
+TYPED_TEST_SUITE(LifetimeTest, QueueTypes);
+
+// elements are constructed on push, destructed on pop, and those left are destructed with the queue
+TYPED_TEST(LifetimeTest, ConstructDestructTest) {
+    std::string payload(64, 'x');
+    {
+        typename TypeParam::template type<Tracked> queue(8);
+        Tracked lvalue(payload);
+        EXPECT_TRUE(queue.push(lvalue));
+        EXPECT_TRUE(queue.push(Tracked(payload)));
+        EXPECT_TRUE(queue.emplace(payload));
+        EXPECT_TRUE(queue.emplace(payload));
+        EXPECT_TRUE(queue.emplace(payload));
+        EXPECT_EQ(Tracked::alive, 6);
+
+        EXPECT_TRUE(queue.pop([&](Tracked& obj) { EXPECT_EQ(obj.payload, payload); }));
+        EXPECT_EQ(Tracked::alive, 5);
+
+        // moved out without any deep copy
+        Tracked out("");
+        EXPECT_TRUE(queue.try_pop(out));
+        EXPECT_EQ(out.payload, payload);
+        std::optional<Tracked> opt = queue.try_pop();
+        ASSERT_TRUE(opt.has_value());
+        EXPECT_EQ(opt->payload, payload);
+        EXPECT_EQ(Tracked::alive, 5);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+    EXPECT_EQ(Tracked::copies, 1);
+}
+
+// move-only elements cross the queue
+TYPED_TEST(LifetimeTest, MoveOnlyTest) {
+    typename TypeParam::template type<std::unique_ptr<uint32_t>> queue(4);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(std::make_unique<uint32_t>(i)));
+    }
+    EXPECT_FALSE(queue.try_pop() == nullptr);
+
+    std::unique_ptr<uint32_t> out;
+    EXPECT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(*out, 1);
+    EXPECT_TRUE(queue.pop([](std::unique_ptr<uint32_t>& obj) { EXPECT_EQ(*obj, 2); }));
+    EXPECT_FALSE(queue.try_pop() == std::nullopt);
+    EXPECT_EQ(queue.try_pop(), std::nullopt);
+    EXPECT_FALSE(queue.try_pop(out));
+}
+
+// the elements of the queue assigned to are destructed and its storage is freed
+TYPED_TEST(LifetimeTest, MoveAssignTest) {
+    using Queue = typename TypeParam::template type<Tracked>;
+    {
+        Queue a(4), b(8);
+        EXPECT_TRUE(a.emplace("a"));
+        EXPECT_TRUE(b.emplace("b"));
+        EXPECT_TRUE(b.emplace("b"));
+        EXPECT_EQ(Tracked::alive, 3);
+
+        b = std::move(a);
+        EXPECT_EQ(Tracked::alive, 1);
+        EXPECT_TRUE(b.pop([](Tracked& obj) { EXPECT_EQ(obj.payload, "a"); }));
+        EXPECT_TRUE(b.emplace("b"));
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// shared slots stay constructed for the lifetime of the queue, and are assigned to by push
+TEST(LifetimeTest, SharedSlotTest) {
+    MpmcSharedQueue<std::string> queue(4);
+    std::string text(64, 'x');
+    EXPECT_TRUE(queue.push(text));
+    EXPECT_TRUE(queue.push(std::string(64, 'y')));
+    EXPECT_TRUE(queue.pop([&](std::string& obj) { EXPECT_EQ(obj, text); }));
+    EXPECT_TRUE(queue.pop([](std::string& obj) { EXPECT_EQ(obj, std::string(64, 'y')); }));
+}
+
+// the sequence queue never gets fewer than two slots, which its sequences need to tell a push from a pop
+TEST(SequenceTest, TinyCapacityTest) {
+    for (uint32_t size : {0U, 1U, 2U}) {
+        MpmcSequenceQueue<int> queue(size);
+        EXPECT_EQ(queue.capacity(), 2);
+        EXPECT_TRUE(queue.push(1));
+        EXPECT_TRUE(queue.push(2));
+        EXPECT_FALSE(queue.push(3));
+
+        for (int round = 0; round < 3; round++) {
+            EXPECT_EQ(queue.try_pop(), std::optional<int>(round + 1));
+            EXPECT_TRUE(queue.push(round + 3));
+        }
+        EXPECT_EQ(queue.try_pop(), std::optional<int>(4));
+        EXPECT_EQ(queue.try_pop(), std::optional<int>(5));
+        EXPECT_EQ(queue.try_pop(), std::nullopt);
+    }
+}
+
+// places claimed but not yet published are not free, though the size does not count them either
+TEST(RoomTest, ClaimedTest) {
+    MpmcUniqueQueue<int> unique(4);
+    EXPECT_EQ(unique.room(), 4);
+    EXPECT_TRUE(unique.push(1));
+    auto token = unique.reserve();
+    EXPECT_EQ(unique.size(), 1);
+    EXPECT_EQ(unique.room(), 2);
+    token.commit();
+    EXPECT_EQ(unique.size(), 2);
+    EXPECT_EQ(unique.room(), 2);
+    EXPECT_TRUE(unique.pop([](int&) {}));
+    EXPECT_EQ(unique.room(), 3);
+
+    SpscQueue<int> spsc(4);
+    EXPECT_TRUE(spsc.push(1));
+    EXPECT_TRUE(spsc.push(2));
+    EXPECT_EQ(spsc.room(), 2);
+    EXPECT_TRUE(spsc.pop([](int&) {}));
+    EXPECT_EQ(spsc.room(), 3);
+
+    MpmcSharedQueue<int> shared(4);
+    EXPECT_EQ(shared.push_bulk([](int& obj) { obj = 0; }, 8), 4);
+    EXPECT_EQ(shared.room(), 0);
+    EXPECT_TRUE(shared.pop([](const int&) {}));
+    EXPECT_EQ(shared.room(), 1);
+}
+
 int main(int argc, char* argv[]) {
     testing::InitGoogleTest(&argc, argv);
     testing::GTEST_FLAG(color) = "yes";
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "broadcast_queue.hpp"
+#include "tools.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+template <typename T>
+class BroadcastTest : public testing::Test {
+  protected:
+    // how many producers we wish to have simultaneously
+    static constexpr uint32_t multiple_cnt = 2;
+
+    BroadcastQueue<T> queue_;
+    uint32_t cnt_;
+    uint32_t uid_;
+
+    BroadcastTest() : queue_(64, 4), cnt_(20000), uid_(random(0U, UINT32_MAX)) {}
+
+    /* every producer pushes its own increasing sequence. */
+    void produce(uint32_t producer) {
+        for (uint32_t i = 0; i < this->cnt_; i++) {
+            while (!this->queue_.push(T(producer, i))) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /* every consumer sees the sequence of each producer completely and in order. */
+    void consume(uint32_t consumer, std::atomic<uint32_t>& read, const std::atomic<uint32_t>* dep) {
+        std::vector<uint32_t> next(multiple_cnt, 0);
+        while (read < multiple_cnt * this->cnt_) {
+            uint32_t n = this->queue_.pop_bulk(
+                consumer,
+                [&](const T& obj) {
+                    EXPECT_EQ(obj.seq, next[obj.uid]++);
+                    // what we read must have been finished by the consumer we depend on
+                    if (dep) {
+                        EXPECT_LT(read.load(), dep->load());
+                    }
+                    read++;
+                },
+                16);
+            if (n == 0) std::this_thread::yield();
+        }
+    }
+};
+
+using TestTypes = testing::Types<TrivialObj, NonTrivialObj>;
+TYPED_TEST_SUITE(BroadcastTest, TestTypes);
+
+// every consumer reads everything, and B only reads behind A
+TYPED_TEST(BroadcastTest, FanOutTest) {
+    uint32_t a = this->queue_.subscribe();
+    uint32_t b = this->queue_.subscribe({a});
+    uint32_t c = this->queue_.subscribe();
+
+    std::atomic<uint32_t> read_a = 0, read_b = 0, read_c = 0;
+    std::vector<std::thread> workers;
+    workers.emplace_back([&]() { this->consume(a, read_a, nullptr); });
+    workers.emplace_back([&]() { this->consume(b, read_b, &read_a); });
+    workers.emplace_back([&]() { this->consume(c, read_c, nullptr); });
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back([this, i]() { this->produce(i); });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(read_a, this->multiple_cnt * this->cnt_);
+    EXPECT_EQ(read_b, this->multiple_cnt * this->cnt_);
+    EXPECT_EQ(read_c, this->multiple_cnt * this->cnt_);
+}
+
+// producers are gated by the slowest consumer
+TYPED_TEST(BroadcastTest, GateTest) {
+    uint32_t a = this->queue_.subscribe();
+    uint32_t b = this->queue_.subscribe();
+
+    for (uint32_t i = 0; i < 64; i++) {
+        EXPECT_TRUE(this->queue_.push(TypeParam(this->uid_, i)));
+    }
+    EXPECT_FALSE(this->queue_.push(TypeParam(this->uid_, 64)));
+
+    // the fast consumer alone makes no room
+    EXPECT_EQ(this->queue_.pop_bulk(a, [](const TypeParam&) {}, 100), 64);
+    EXPECT_FALSE(this->queue_.push(TypeParam(this->uid_, 64)));
+
+    EXPECT_TRUE(this->queue_.pop(b, [this](const TypeParam& obj) { EXPECT_EQ(obj.seq, 0); }));
+    EXPECT_TRUE(this->queue_.push(TypeParam(this->uid_, 64)));
+    EXPECT_TRUE(this->queue_.pop(a, [](const TypeParam&) {}));
+    EXPECT_FALSE(this->queue_.pop(a, [](const TypeParam&) {}));
+
+    // dependencies must exist, and no more consumers than reserved
+    EXPECT_THROW(this->queue_.subscribe({a, 7}), std::out_of_range);
+    this->queue_.subscribe({a, b});
+    this->queue_.subscribe();
+    EXPECT_THROW(this->queue_.subscribe(), std::length_error);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <thread>
+
+#include "byte_queue.hpp"
+#include "tools.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+// every message starts with its producer and sequence, followed by a pattern derived from them
+struct Frame {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+static uint32_t frameLength(uint32_t producer, uint32_t seq) { return sizeof(Frame) + (seq * 37 + producer) % 300; }
+
+static void fillFrame(std::span<std::byte> msg, uint32_t producer, uint32_t seq) {
+    Frame frame{producer, seq};
+    std::memcpy(msg.data(), &frame, sizeof(frame));
+    for (size_t i = sizeof(frame); i < msg.size(); i++) {
+        msg[i] = static_cast<std::byte>(producer + seq + i);
+    }
+}
+
+static Frame checkFrame(std::span<const std::byte> msg) {
+    Frame frame;
+    std::memcpy(&frame, msg.data(), sizeof(frame));
+    EXPECT_EQ(msg.size(), frameLength(frame.producer, frame.seq));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(msg.data()) % 8, 0);
+    for (size_t i = sizeof(frame); i < msg.size(); i++) {
+        if (msg[i] != static_cast<std::byte>(frame.producer + frame.seq + i)) {
+            ADD_FAILURE() << "corrupted byte " << i << " of message " << frame.seq;
+            break;
+        }
+    }
+    return frame;
+}
+
+// records of varying length wrap around a small ring through padding, and are read in order and in place
+TEST(SpscByteQueueTest, OrderTest) {
+    SpscByteQueue queue(1024);
+    constexpr uint32_t cnt = 100000;
+
+    std::thread writer([&queue]() {
+        for (uint32_t seq = 0; seq < cnt; seq++) {
+            std::span<std::byte> msg;
+            while ((msg = queue.reserve(frameLength(0, seq))).data() == nullptr) {
+                std::this_thread::yield();
+            }
+            fillFrame(msg, 0, seq);
+            queue.commit(msg);
+        }
+    });
+
+    for (uint32_t seq = 0; seq < cnt;) {
+        std::span<const std::byte> msg = queue.read();
+        if (msg.data() == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        EXPECT_EQ(checkFrame(msg).seq, seq++);
+        queue.release();
+    }
+
+    writer.join();
+    EXPECT_EQ(queue.size(), 0);
+}
+
+// a reservation may be committed shorter, and messages beyond the half of the ring are refused
+TEST(SpscByteQueueTest, ReserveTest) {
+    SpscByteQueue queue(256);
+    EXPECT_EQ(queue.capacity(), 256);
+    EXPECT_EQ(queue.max_message(), 120);
+    EXPECT_THROW(queue.reserve(121), std::length_error);
+    EXPECT_EQ(queue.read().data(), nullptr);
+
+    std::span<std::byte> msg = queue.reserve(100);
+    ASSERT_EQ(msg.size(), 100);
+    std::memcpy(msg.data(), "frame", 5);
+    queue.commit(msg, 5);
+    EXPECT_EQ(queue.size(), 16);
+
+    std::span<const std::byte> read = queue.read();
+    ASSERT_EQ(read.size(), 5);
+    EXPECT_EQ(std::memcmp(read.data(), "frame", 5), 0);
+    queue.release();
+
+    // fill the ring up with records of 8 + 112 bytes
+    std::vector<std::byte> payload(112);
+    EXPECT_TRUE(queue.push(payload));
+    EXPECT_TRUE(queue.push(payload));
+    EXPECT_FALSE(queue.push(payload));
+    EXPECT_EQ(queue.read().size(), 112);
+    queue.release();
+    EXPECT_TRUE(queue.push(payload));
+}
+
+// producers commit out of order and the consumer sees the sequence of every producer in order
+TEST(MpscByteQueueTest, MpscTest) {
+    MpscByteQueue queue(4096);
+    constexpr uint32_t producers = 3, cnt = 50000;
+
+    std::vector<std::thread> writers;
+    for (uint32_t p = 0; p < producers; p++) {
+        writers.emplace_back([&queue, p]() {
+            for (uint32_t seq = 0; seq < cnt; seq++) {
+                std::span<std::byte> msg;
+                while ((msg = queue.reserve(frameLength(p, seq))).data() == nullptr) {
+                    std::this_thread::yield();
+                }
+                fillFrame(msg, p, seq);
+                queue.commit(msg);
+            }
+        });
+    }
+
+    std::vector<uint32_t> next(producers, 0);
+    for (uint32_t popped = 0; popped < producers * cnt;) {
+        std::span<const std::byte> msg = queue.read();
+        if (msg.data() == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        Frame frame = checkFrame(msg);
+        EXPECT_EQ(frame.seq, next[frame.producer]++);
+        queue.release();
+        popped++;
+    }
+
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(queue.size(), 0);
+}
+
+// a reservation committed shorter keeps its room, so the records claimed behind it stay in place
+TEST(MpscByteQueueTest, ReserveTest) {
+    MpscByteQueue queue(256);
+    std::span<std::byte> first = queue.reserve(40), second = queue.reserve(8);
+    ASSERT_NE(first.data(), nullptr);
+    ASSERT_NE(second.data(), nullptr);
+
+    // the second one is committed first but has to wait for the first one
+    std::memcpy(second.data(), "second", 6);
+    queue.commit(second, 6);
+    EXPECT_EQ(queue.read().data(), nullptr);
+
+    std::memcpy(first.data(), "first", 5);
+    queue.commit(first, 5);
+    EXPECT_EQ(queue.size(), 64);
+
+    std::span<const std::byte> read = queue.read();
+    ASSERT_EQ(read.size(), 5);
+    EXPECT_EQ(std::memcmp(read.data(), "first", 5), 0);
+    queue.release();
+    read = queue.read();
+    ASSERT_EQ(read.size(), 6);
+    EXPECT_EQ(std::memcmp(read.data(), "second", 6), 0);
+    queue.release();
+    EXPECT_EQ(queue.read().data(), nullptr);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
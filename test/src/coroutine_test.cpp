@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "coroutine.hpp"
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "tools.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+// the awaitable and blocking interfaces exist only on queues built for them
+template <typename T>
+using WaitableSpscQueue = SpscQueue<T, std::allocator<T>, NoStats, true>;
+template <typename T>
+using WaitableMpmcQueue = MpmcUniqueQueue<T, std::allocator<T>, NoStats, PauseBackoff, true>;
+
+// the queue is kept small so both sides get suspended again and again
+static constexpr uint32_t capacity = 4;
+static constexpr uint32_t cnt = 20000;
+
+template <typename Queue, typename S>
+AsyncTask produce(Queue& queue, S& scheduler, uint32_t from, uint32_t n) {
+    for (uint32_t i = from; i < from + n; i++) {
+        co_await queue.async_push(i, scheduler);
+    }
+}
+
+template <typename Queue, typename S>
+AsyncTask consume(Queue& queue, S& scheduler, uint32_t n, std::vector<uint32_t>& out) {
+    for (uint32_t i = 0; i < n; i++) {
+        out.push_back(co_await queue.async_pop(scheduler));
+    }
+}
+
+template <typename Queue>
+class CoroutineTest : public testing::Test {};
+
+using Queues = testing::Types<WaitableSpscQueue<uint32_t>, WaitableMpmcQueue<uint32_t>>;
+TYPED_TEST_SUITE(CoroutineTest, Queues);
+
+// the awaitables complete without suspending while there is room or data
+TYPED_TEST(CoroutineTest, ReadyTest) {
+    TypeParam queue(capacity);
+    EXPECT_FALSE(queue.async_pop().await_ready());
+    for (uint32_t i = 0; i < capacity; i++) {
+        EXPECT_TRUE(queue.async_push(i).await_ready());
+    }
+    EXPECT_FALSE(queue.async_push(0U).await_ready());
+
+    auto pop = queue.async_pop();
+    EXPECT_TRUE(pop.await_ready());
+    EXPECT_EQ(pop.await_resume(), 0);
+    EXPECT_EQ(queue.size(), capacity - 1);
+}
+
+// both sides on one loop hand over to each other whenever the queue is full or empty
+TYPED_TEST(CoroutineTest, LoopTest) {
+    TypeParam queue(capacity);
+    LoopScheduler loop;
+    std::vector<uint32_t> out;
+
+    loop.spawn(consume(queue, loop, cnt, out));
+    loop.spawn(produce(queue, loop, 0, cnt));
+    loop.run();
+
+    ASSERT_EQ(out.size(), cnt);
+    for (uint32_t i = 0; i < cnt; i++) {
+        EXPECT_EQ(out[i], i);
+    }
+}
+
+// without a scheduler the suspended side is resumed right within the push or pop of the other
+TYPED_TEST(CoroutineTest, InlineTest) {
+    TypeParam queue(capacity);
+    LoopScheduler loop;
+    std::vector<uint32_t> out;
+
+    loop.spawn(consume(queue, inline_scheduler, cnt, out));
+    loop.spawn(produce(queue, inline_scheduler, 0, cnt));
+    loop.run();
+
+    ASSERT_EQ(out.size(), cnt);
+    for (uint32_t i = 0; i < cnt; i++) {
+        EXPECT_EQ(out[i], i);
+    }
+}
+
+// a blocked thread on one side and a coroutine on the other wake each other
+TYPED_TEST(CoroutineTest, ThreadTest) {
+    TypeParam queue(capacity);
+    std::vector<uint32_t> out;
+    {
+        LoopScheduler loop;
+        std::thread producer([&queue]() {
+            for (uint32_t i = 0; i < cnt; i++) {
+                queue.push_wait(i);
+            }
+        });
+        loop.spawn(consume(queue, loop, cnt, out));
+        loop.run();
+        producer.join();
+    }
+
+    std::thread consumer([&queue]() {
+        for (uint32_t i = 0; i < cnt; i++) {
+            queue.pop_wait([i](uint32_t& obj) { EXPECT_EQ(obj, i); });
+        }
+    });
+    LoopScheduler loop;
+    loop.spawn(produce(queue, loop, 0, cnt));
+    loop.run();
+    consumer.join();
+
+    ASSERT_EQ(out.size(), cnt);
+    for (uint32_t i = 0; i < cnt; i++) {
+        EXPECT_EQ(out[i], i);
+    }
+}
+
+// several producer coroutines on one loop and several consumer coroutines on another
+TEST(AwaitTest, MpmcTest) {
+    WaitableMpmcQueue<uint32_t> queue(capacity);
+    constexpr uint32_t multiple_cnt = 3;
+    std::vector<std::vector<uint32_t>> outs(multiple_cnt);
+
+    LoopScheduler producers, consumers;
+    for (uint32_t i = 0; i < multiple_cnt; i++) {
+        producers.spawn(produce(queue, producers, i * cnt, cnt));
+        consumers.spawn(consume(queue, consumers, cnt, outs[i]));
+    }
+    std::thread thread([&producers]() { producers.run(); });
+    consumers.run();
+    thread.join();
+
+    // every value is popped once, and those of one producer in order by every consumer
+    std::vector<uint32_t> seen(multiple_cnt * cnt, 0);
+    for (auto& out : outs) {
+        ASSERT_EQ(out.size(), cnt);
+        std::vector<uint32_t> last(multiple_cnt, 0);
+        for (uint32_t val : out) {
+            seen[val]++;
+            uint32_t producer = val / cnt;
+            EXPECT_GE(val, last[producer]);
+            last[producer] = val + 1;
+        }
+    }
+    for (uint32_t times : seen) {
+        EXPECT_EQ(times, 1);
+    }
+}
+
+AsyncTask passOn(WaitableSpscQueue<std::unique_ptr<uint32_t>>& queue, LoopScheduler& loop) {
+    for (uint32_t i = 0; i < cnt; i++) {
+        co_await queue.async_push(std::make_unique<uint32_t>(i), loop);
+    }
+}
+
+AsyncTask takeOver(WaitableSpscQueue<std::unique_ptr<uint32_t>>& queue, LoopScheduler& loop, uint32_t& sum) {
+    for (uint32_t i = 0; i < cnt; i++) {
+        std::unique_ptr<uint32_t> ptr = co_await queue.async_pop(loop);
+        sum += *ptr;
+    }
+}
+
+// move-only elements are moved in and out of the awaitables
+TEST(AwaitTest, MoveOnlyTest) {
+    WaitableSpscQueue<std::unique_ptr<uint32_t>> queue(capacity);
+    LoopScheduler loop;
+    uint32_t sum = 0;
+
+    loop.spawn(takeOver(queue, loop, sum));
+    loop.spawn(passOn(queue, loop));
+    loop.run();
+    EXPECT_EQ(sum, cnt * (cnt - 1) / 2);
+    EXPECT_EQ(queue.size(), 0);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+#include "mpmc_unique_queue.hpp"
+#include "spsc_queue.hpp"
+#include "stats.hpp"
+
+using namespace lfcq;
+
+/* whether <fd> is readable right now. */
+static bool readable(int fd) {
+    pollfd pfd{fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
+}
+
+template <typename Queue>
+class EventTest : public testing::Test {};
+
+using Queues = testing::Types<SpscQueue<uint32_t, std::allocator<uint32_t>, ShardedStats<>, true>,
+                              MpmcUniqueQueue<uint32_t, std::allocator<uint32_t>, ShardedStats<>, PauseBackoff, true>>;
+TYPED_TEST_SUITE(EventTest, Queues);
+
+// the fd becomes readable on the first push after arming only, and arming reads the event
+TYPED_TEST(EventTest, ArmTest) {
+    TypeParam queue(8);
+    int fd = queue.fd();
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(queue.fd(), fd);
+    EXPECT_FALSE(readable(fd));
+
+    // pushes before arming make no event
+    EXPECT_TRUE(queue.push(0U));
+    EXPECT_FALSE(readable(fd));
+    EXPECT_FALSE(queue.arm());
+    EXPECT_TRUE(queue.pop([](uint32_t&) {}));
+
+    EXPECT_TRUE(queue.arm());
+    EXPECT_FALSE(readable(fd));
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(i));
+        EXPECT_TRUE(readable(fd));
+    }
+    EXPECT_EQ(queue.stats().event_signals, 1);
+
+    // the queue is not drained yet, so arming is refused, but the event has been read as the loop goes on popping
+    EXPECT_FALSE(queue.arm());
+    EXPECT_FALSE(readable(fd));
+
+    while (queue.pop([](uint32_t&) {})) {}
+    EXPECT_TRUE(queue.arm());
+    EXPECT_FALSE(readable(fd));
+
+    EXPECT_TRUE(queue.push(0U));
+    EXPECT_TRUE(readable(fd));
+    EXPECT_EQ(queue.stats().event_signals, 2);
+}
+
+// a consumer in an epoll loop receives every message of a bursty producer without a write per message
+TYPED_TEST(EventTest, EpollTest) {
+    TypeParam queue(64);
+    constexpr uint32_t bursts = 200, burst = 50;
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    ASSERT_GE(epfd, 0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    ASSERT_EQ(epoll_ctl(epfd, EPOLL_CTL_ADD, queue.fd(), &event), 0);
+
+    std::thread producer([&queue]() {
+        for (uint32_t i = 0; i < bursts; i++) {
+            for (uint32_t j = 0; j < burst; j++) {
+                while (!queue.push(i * burst + j)) {
+                    std::this_thread::yield();
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    uint32_t next = 0, wakeups = 0;
+    while (next < bursts * burst) {
+        while (queue.pop([&next](uint32_t& obj) { EXPECT_EQ(obj, next++); })) {}
+        if (next == bursts * burst || !queue.arm()) continue;
+
+        // a timeout here means a lost wakeup
+        ASSERT_EQ(epoll_wait(epfd, &event, 1, 10000), 1);
+        wakeups++;
+    }
+    producer.join();
+    close(epfd);
+
+    EXPECT_EQ(next, bursts * burst);
+    EXPECT_LE(queue.stats().event_signals, wakeups);
+    EXPECT_LT(queue.stats().event_signals, bursts * burst);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "executor.hpp"
+
+using namespace lfcq;
+
+// small movable callables are kept inline, anything else on the heap, and either is run once and destructed
+TEST(ExecutorTest, TaskTest) {
+    int cnt = 0;
+    Task small([&cnt]() { cnt++; });
+    Task moved = std::move(small);
+    EXPECT_FALSE(small);
+    moved();
+    EXPECT_EQ(cnt, 1);
+    EXPECT_FALSE(moved);
+
+    std::string text = "a long string kept by a callable which is not trivially copyable";
+    std::string seen;
+    Task inlined([text, &seen]() { seen = text; });
+    inlined();
+    EXPECT_EQ(seen, text);
+
+    std::array<char, Task::INLINE_SIZE> bytes{'x'};
+    char first = 0;
+    Task large([bytes, &first]() { first = bytes[0]; });
+    Task other;
+    other = std::move(large);
+    other();
+    EXPECT_EQ(first, 'x');
+
+    EXPECT_FALSE(Task());
+}
+
+// a callable of a task never run is destructed with it, wherever it is stored
+TEST(ExecutorTest, TaskLifetimeTest) {
+    auto token = std::make_shared<int>(0);
+    {
+        Task inlined([token]() {});
+        Task large([token, pad = std::array<char, Task::INLINE_SIZE>{}]() {});
+        EXPECT_EQ(token.use_count(), 3);
+
+        Task moved = std::move(large);
+        inlined = std::move(moved);
+        EXPECT_EQ(token.use_count(), 2);
+    }
+    EXPECT_EQ(token.use_count(), 1);
+}
+
+// futures of the owner's submissions, which go through the inboxes
+TEST(ExecutorTest, SubmitTest) {
+    ExecutorOptions options;
+    options.workers = 4;
+    options.inbox = 4;
+    options.overflow = 16;
+    Executor executor(options);
+    EXPECT_EQ(executor.size(), 4);
+
+    auto square = executor.submit([]() { return 7 * 7; });
+    auto text = executor.submit([]() { return std::string("future"); });
+    std::atomic<bool> ran = false;
+    auto nothing = executor.submit([&ran]() { ran = true; });
+
+    EXPECT_EQ(square.get(), 49);
+    EXPECT_EQ(text.get(), "future");
+    nothing.get();
+    EXPECT_TRUE(ran);
+    EXPECT_TRUE(nothing.ready());
+}
+
+// other threads and tasks themselves submit through the overflow queue, and everything runs before destruction
+TEST(ExecutorTest, OverflowTest) {
+    constexpr uint32_t submitters = 3, per_thread = 20000;
+    std::atomic<uint32_t> done = 0;
+    {
+        ExecutorOptions options;
+        options.workers = 3;
+        options.inbox = 8;
+        options.overflow = 64;
+        Executor executor(options);
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < submitters; i++) {
+            threads.emplace_back([&]() {
+                for (uint32_t j = 0; j < per_thread; j++) {
+                    executor.post([&]() { done++; });
+                }
+            });
+        }
+
+        // the owner forks from inside the tasks as well
+        for (uint32_t j = 0; j < per_thread; j++) {
+            executor.post([&]() { executor.post([&]() { done++; }); });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        auto last = executor.submit([]() { return 1; });
+        EXPECT_EQ(last.get(), 1);
+    }
+    EXPECT_EQ(done, (submitters + 1) * per_thread);
+}
+
+// a callable failing to be copied into a task reaches the submitter instead of terminating
+TEST(ExecutorTest, ThrowingCallableTest) {
+    struct Throwing {
+        Throwing() = default;
+        Throwing(const Throwing&) { throw std::runtime_error("copy"); }
+        void operator()() const {}
+    };
+
+    ExecutorOptions options;
+    options.workers = 1;
+    Executor executor(options);
+    const Throwing func;
+    EXPECT_THROW(executor.post(func), std::runtime_error);
+    EXPECT_THROW(executor.submit(func), std::runtime_error);
+    EXPECT_EQ(executor.submit([]() { return 1; }).get(), 1);
+}
+
+// parked workers are woken by new tasks
+TEST(ExecutorTest, ParkTest) {
+    ExecutorOptions options;
+    options.workers = 2;
+    options.cpus = {0};
+    options.idle = WaitPolicy{0, 0, 0};
+    Executor executor(options);
+    for (uint32_t i = 0; i < 100; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        auto future = executor.submit([i]() { return i; });
+        EXPECT_EQ(future.get(), i);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <thread>
 
 #include "mpmc_unique_queue.hpp"
 #include "tools.hpp"
@@ -106,6 +108,162 @@ TYPED_TEST(MpmcUniqueTest, MpmcTest) {
     EXPECT_EQ(this->w_checksum_, this->r_checksum_);
 }
 
+// multiple producers & multiple consumers through bulk interfaces
+TYPED_TEST(MpmcUniqueTest, BulkTest) {
+    auto push = [this]() {
+        // claim a batch of the shared counter and push it until all of the batch got in
+        for (uint32_t beg; (beg = this->w_cnt_.fetch_add(32)) < this->cnt_;) {
+            uint32_t n = std::min(32U, this->cnt_ - beg);
+            std::vector<uint32_t> seqs(n);
+            for (auto& seq : seqs) {
+                seq = random(1U, UINT32_MAX);
+                this->w_checksum_ ^= seq;
+            }
+            for (uint32_t i = 0, j = 0; i < n; j = i) {
+                i += this->queue_.push_bulk(
+                    [this, &seqs, &j](TypeParam& obj) { new (&obj) TypeParam(this->uid_, seqs[j++]); }, n - i);
+            }
+        }
+    };
+
+    auto pop = [this]() {
+        std::vector<TypeParam> objs;
+        while (this->r_cnt_ < this->cnt_) {
+            objs.clear();
+            uint32_t n = this->queue_.pop_bulk(std::back_inserter(objs), random(1U, 64U));
+            for (auto& obj : objs) {
+                EXPECT_EQ(obj.uid, this->uid_);
+                this->r_checksum_ ^= obj.seq;
+            }
+            this->r_cnt_ += n;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back(push);
+        workers.emplace_back(pop);
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(this->w_checksum_, this->r_checksum_);
+}
+
+// multiple producers & multiple consumers copying contiguous batches across the wrap of a small ring
+TYPED_TEST(MpmcUniqueTest, CopyBulkTest) {
+    MpmcUniqueQueue<TypeParam> queue(64);
+    auto push = [this, &queue]() {
+        std::vector<TypeParam> batch;
+        for (uint32_t beg; (beg = this->w_cnt_.fetch_add(32)) < this->cnt_;) {
+            batch.clear();
+            for (uint32_t i = 0; i < std::min(32U, this->cnt_ - beg); i++) {
+                uint32_t seq = random(1U, UINT32_MAX);
+                this->w_checksum_ ^= seq;
+                batch.emplace_back(this->uid_, seq);
+            }
+            for (TypeParam *it = batch.data(), *end = it + batch.size(); it != end;) {
+                it += queue.template push_bulk<CopyMode::Streaming>(it, end);
+            }
+        }
+    };
+
+    auto pop = [this, &queue]() {
+        std::vector<TypeParam> buffer(64, TypeParam{0, 0});
+        while (this->r_cnt_ < this->cnt_) {
+            uint32_t n = queue.pop_bulk(buffer.data(), random(1U, 64U));
+            for (uint32_t i = 0; i < n; i++) {
+                EXPECT_EQ(buffer[i].uid, this->uid_);
+                this->r_checksum_ ^= buffer[i].seq;
+            }
+            this->r_cnt_ += n;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back(push);
+        workers.emplace_back(pop);
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(this->w_checksum_, this->r_checksum_);
+}
+
+// multiple producers & multiple consumers filling and reading slots in place
+TYPED_TEST(MpmcUniqueTest, TokenTest) {
+    uint32_t per_thread = this->cnt_ / this->multiple_cnt;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back([this, per_thread]() {
+            for (uint32_t j = 0; j < per_thread;) {
+                auto token = this->queue_.reserve();
+                if (!token) continue;
+
+                uint32_t seq = random(0U, UINT32_MAX);
+                token->uid = this->uid_;
+                token->seq = seq;
+                token.commit();
+                this->w_checksum_ ^= seq;
+                j++;
+            }
+        });
+        workers.emplace_back([this, per_thread]() {
+            for (uint32_t j = 0; j < per_thread;) {
+                auto token = this->queue_.peek();
+                if (!token) continue;
+
+                EXPECT_EQ(token->uid, this->uid_);
+                this->r_checksum_ ^= token->seq;
+                j++;
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(this->w_checksum_, this->r_checksum_);
+    EXPECT_FALSE(this->queue_.peek());
+}
+
+// multiple producers & multiple consumers sleeping on a tiny queue
+TYPED_TEST(MpmcUniqueTest, BlockingTest) {
+    MpmcUniqueQueue<TypeParam, std::allocator<TypeParam>, NoStats, PauseBackoff, true> queue(4);
+    uint32_t per_thread = this->cnt_ / this->multiple_cnt;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back([this, &queue, per_thread]() {
+            for (uint32_t j = 0; j < per_thread; j++) {
+                uint32_t seq = random(0U, UINT32_MAX);
+                queue.push_wait(TypeParam(this->uid_, seq));
+                this->w_checksum_ ^= seq;
+            }
+        });
+        workers.emplace_back([this, &queue, per_thread]() {
+            for (uint32_t j = 0; j < per_thread; j++) {
+                queue.pop_wait([this](TypeParam& obj) {
+                    EXPECT_EQ(obj.uid, this->uid_);
+                    this->r_checksum_ ^= obj.seq;
+                });
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(this->w_checksum_, this->r_checksum_);
+
+    // every element has been consumed so the timed pop gives up
+    EXPECT_FALSE(queue.pop_for([](TypeParam&) {}, std::chrono::milliseconds(10)));
+}
+
 TYPED_TEST(MpmcUniqueTest, LoopWriteTest) {
     // there will be slots written to more than one times, a.k.a loop write
     this->cnt_ = 8000;
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "priority_queue.hpp"
+#include "tools.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+template <typename T>
+class PriorityTest : public testing::Test {
+  protected:
+    // how many producers / consumers we wish to have simultaneously
+    static constexpr uint32_t multiple_cnt = 3;
+    static constexpr uint32_t levels = 4;
+
+    PriorityQueue<T, levels> queue_;
+    uint32_t cnt_;
+    uint32_t uid_;
+
+    std::atomic<uint32_t> w_checksum_;
+    std::atomic<uint32_t> r_checksum_;
+
+    PriorityTest() : queue_(16), cnt_(30000), uid_(random(0U, UINT32_MAX)), w_checksum_(0), r_checksum_(0) {}
+};
+
+using TestTypes = testing::Types<TrivialObj, NonTrivialObj>;
+TYPED_TEST_SUITE(PriorityTest, TestTypes);
+
+// higher levels are popped first, and each level keeps its own order
+TYPED_TEST(PriorityTest, OrderTest) {
+    for (uint32_t level = this->levels; level-- > 0;) {
+        for (uint32_t i = 0; i < 16; i++) {
+            EXPECT_TRUE(this->queue_.push(level, TypeParam(level, i)));
+        }
+        EXPECT_FALSE(this->queue_.emplace(level, level, 16U));
+    }
+
+    for (uint32_t level = 0; level < this->levels; level++) {
+        for (uint32_t i = 0; i < 16; i++) {
+            EXPECT_TRUE(this->queue_.pop([level, i](TypeParam& obj) {
+                EXPECT_EQ(obj.uid, level);
+                EXPECT_EQ(obj.seq, i);
+            }));
+        }
+    }
+    EXPECT_FALSE(this->queue_.pop([](TypeParam&) {}));
+
+    // a level found empty is pushed to again
+    EXPECT_TRUE(this->queue_.push(3, TypeParam(3, 0)));
+    EXPECT_TRUE(this->queue_.pop([](TypeParam& obj) { EXPECT_EQ(obj.uid, 3); }));
+}
+
+// lower levels get <low> elements after every <high> elements while they wait
+TYPED_TEST(PriorityTest, FairnessTest) {
+    for (uint32_t i = 0; i < 12; i++) {
+        EXPECT_TRUE(this->queue_.push(0, TypeParam(0, i)));
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(this->queue_.push(2, TypeParam(2, i)));
+    }
+
+    Fairness fairness{4, 1};
+    std::vector<uint32_t> order;
+    while (this->queue_.pop([&](TypeParam& obj) { order.push_back(obj.uid); }, fairness)) {}
+
+    std::vector<uint32_t> expected = {0, 0, 0, 0, 2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 2, 2};
+    EXPECT_EQ(order, expected);
+}
+
+// multiple producers & multiple consumers, no element is missed by the non-empty mask
+TYPED_TEST(PriorityTest, MpmcTest) {
+    uint32_t per_thread = this->cnt_ / this->multiple_cnt;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back([this, per_thread]() {
+            for (uint32_t j = 0; j < per_thread; j++) {
+                uint32_t seq = random(0U, UINT32_MAX);
+                while (!this->queue_.push(seq % this->levels, TypeParam(this->uid_, seq))) {
+                    std::this_thread::yield();
+                }
+                this->w_checksum_ ^= seq;
+            }
+        });
+        workers.emplace_back([this, i, per_thread]() {
+            Fairness fairness{3, 1};
+            for (uint32_t j = 0; j < per_thread;) {
+                auto handle = [this](TypeParam& obj) {
+                    EXPECT_EQ(obj.uid, this->uid_);
+                    this->r_checksum_ ^= obj.seq;
+                };
+                bool popped = i % 2 == 0 ? this->queue_.pop(handle) : this->queue_.pop(handle, fairness);
+                if (popped) {
+                    j++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(this->w_checksum_, this->r_checksum_);
+    EXPECT_FALSE(this->queue_.pop([](TypeParam&) {}));
+}
+
+// many producers on one low level against consumers draining it to empty over and over, an element pushed while
+// a consumer clears the bit must never be stranded behind it
+TEST(PriorityStressTest, StrandTest) {
+    constexpr uint32_t producers = 4, consumers = 2, per_thread = 20000;
+    PriorityQueue<uint32_t, 8> queue(4);
+    std::atomic<uint32_t> popped = 0;
+    std::atomic<uint32_t> running = producers;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < producers; i++) {
+        workers.emplace_back([&queue, &running]() {
+            for (uint32_t j = 0; j < per_thread; j++) {
+                while (!queue.push(0, j)) {
+                    std::this_thread::yield();
+                }
+            }
+            running--;
+        });
+    }
+    for (uint32_t i = 0; i < consumers; i++) {
+        workers.emplace_back([&queue, &popped, &running]() {
+            while (running != 0) {
+                while (queue.pop([](uint32_t&) {})) {
+                    popped++;
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // whatever is left must still be reachable through the mask
+    while (queue.pop([](uint32_t&) {})) {
+        popped++;
+    }
+    EXPECT_EQ(popped, producers * per_thread);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "sharded_queue.hpp"
+#include "tools.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+// how many producers / consumers we wish to have simultaneously
+static constexpr uint32_t multiple_cnt = 4;
+
+// a single consumer sees the sequence of every producer in order
+template <Selection Select>
+void perProducerFifo() {
+    ShardedQueue<TrivialObj, SpscQueue<TrivialObj>, Select> queue(multiple_cnt, 64);
+    constexpr uint32_t cnt = 20000;
+
+    std::vector<std::thread> producers;
+    for (uint32_t i = 0; i < multiple_cnt; i++) {
+        producers.emplace_back([&queue]() {
+            uint32_t shard = queue.attach();
+            for (uint32_t j = 0; j < cnt; j++) {
+                while (!queue.push(shard, TrivialObj{shard, j})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<uint32_t> next(multiple_cnt, 0);
+    for (uint32_t popped = 0; popped < multiple_cnt * cnt;) {
+        if (queue.pop([&](TrivialObj& obj) { EXPECT_EQ(obj.seq, next[obj.uid]++); })) {
+            popped++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(ShardedTest, RoundRobinFifoTest) { perProducerFifo<Selection::RoundRobin>(); }
+
+TEST(ShardedTest, TwoChoicesFifoTest) { perProducerFifo<Selection::TwoChoices>(); }
+
+// more producers than shards share them, and multiple consumers fan in
+TEST(ShardedTest, MpmcTest) {
+    ShardedQueue<NonTrivialObj, MpmcUniqueQueue<NonTrivialObj>, Selection::TwoChoices> queue(3, 32);
+    constexpr uint32_t per_thread = 10000;
+    uint32_t uid = random(0U, UINT32_MAX);
+    std::atomic<uint32_t> w_checksum = 0, r_checksum = 0;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < multiple_cnt; i++) {
+        workers.emplace_back([&]() {
+            uint32_t shard = queue.attach();
+            for (uint32_t j = 0; j < per_thread; j++) {
+                uint32_t seq = random(0U, UINT32_MAX);
+                while (!queue.emplace(shard, uid, seq)) {
+                    std::this_thread::yield();
+                }
+                w_checksum ^= seq;
+            }
+        });
+        workers.emplace_back([&]() {
+            for (uint32_t j = 0; j < per_thread;) {
+                bool popped = queue.pop([&](NonTrivialObj& obj) {
+                    EXPECT_EQ(obj.uid, uid);
+                    r_checksum ^= obj.seq;
+                });
+                if (popped) {
+                    j++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(w_checksum, r_checksum);
+}
+
+// exclusive shards admit one producer each, and the sizes add up over the shards
+TEST(ShardedTest, AttachTest) {
+    ShardedQueue<TrivialObj, SpscQueue<TrivialObj>> queue(2, 4);
+    EXPECT_TRUE(queue.exclusive);
+    EXPECT_EQ(queue.attach(), 0);
+    EXPECT_EQ(queue.attach(), 1);
+    EXPECT_THROW(queue.attach(), std::length_error);
+
+    EXPECT_EQ(queue.capacity(), 8);
+    EXPECT_TRUE(queue.push(0, TrivialObj{0, 0}));
+    EXPECT_TRUE(queue.push(1, [](TrivialObj& obj) { obj = TrivialObj{1, 0}; }));
+    EXPECT_EQ(queue.size(), 2);
+
+    ShardedQueue<TrivialObj> shared(2, 4);
+    EXPECT_FALSE(shared.exclusive);
+    for (uint32_t i = 0; i < 5; i++) {
+        EXPECT_EQ(shared.attach(), i % 2);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
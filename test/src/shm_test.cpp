@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+
+#include "shm_mpmc_unique_queue.hpp"
+#include "shm_spsc_queue.hpp"
+#include "tools.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+template <typename T>
+class ShmTest : public testing::Test {
+  protected:
+    std::string name_;
+    uint32_t size_;
+    uint32_t cnt_;
+
+    ShmTest() : name_("/lfcq_test_" + std::to_string(getpid())), size_(1000), cnt_(100000) {}
+
+    /* run <func> in a child process. */
+    template <typename F>
+    static pid_t spawn(F&& func) {
+        pid_t pid = fork();
+        if (pid == 0) _exit(func() ? 0 : 1);
+        return pid;
+    }
+
+    /* wait for the child process, return whether it exited with 0. */
+    static bool join(pid_t pid) {
+        int status;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+};
+
+using TestTypes = testing::Types<TrivialObj, NonTrivialObj>;
+TYPED_TEST_SUITE(ShmTest, TestTypes);
+
+TYPED_TEST(ShmTest, Attach) {
+    auto queue = ShmSpscQueue<TypeParam>::create(this->name_, this->size_);
+    EXPECT_EQ(queue.capacity(), alignUpPowOf2(this->size_));
+    EXPECT_TRUE(queue.push(TypeParam{1, 2}));
+
+    // another handle on the same segment sees the element
+    auto other = ShmSpscQueue<TypeParam>::attach(this->name_);
+    EXPECT_EQ(other.capacity(), queue.capacity());
+    EXPECT_TRUE(other.pop([](TypeParam& obj) { EXPECT_EQ(obj, (TypeParam{1, 2})); }));
+    EXPECT_FALSE(other.pop([](TypeParam&) {}));
+
+    // the header tells the queues apart
+    EXPECT_THROW(ShmMpmcUniqueQueue<TypeParam>::attach(this->name_), std::runtime_error);
+    EXPECT_THROW(ShmSpscQueue<uint64_t>::attach("/lfcq_test_missing"), std::system_error);
+    EXPECT_THROW(ShmSpscQueue<TypeParam>::create(this->name_, this->size_), std::system_error);
+}
+
+TYPED_TEST(ShmTest, SpscAcrossProcesses) {
+    auto queue = ShmSpscQueue<TypeParam>::create(this->name_, this->size_);
+
+    // the child attaches by name and produces while we consume
+    pid_t pid = this->spawn([this]() {
+        auto producer = ShmSpscQueue<TypeParam>::attach(this->name_);
+        for (uint32_t i = 0; i < this->cnt_; i++) {
+            while (!producer.push(TypeParam{0, i})) {}
+        }
+        return true;
+    });
+
+    for (uint32_t i = 0; i < this->cnt_; i++) {
+        while (!queue.pop([i](TypeParam& obj) { EXPECT_EQ(obj.seq, i); })) {}
+    }
+    EXPECT_TRUE(this->join(pid));
+}
+
+TYPED_TEST(ShmTest, MpmcAcrossProcesses) {
+    auto queue = ShmMpmcUniqueQueue<TypeParam>::create(this->size_);
+
+    // two children attached by descriptor produce interleaved sequences
+    pid_t pids[2];
+    for (uint32_t uid = 0; uid < 2; uid++) {
+        pids[uid] = this->spawn([&]() {
+            auto producer = ShmMpmcUniqueQueue<TypeParam>::attach(queue.fd());
+            for (uint32_t i = 0; i < this->cnt_; i++) {
+                while (!producer.push(TypeParam{uid, i})) {}
+            }
+            return true;
+        });
+    }
+
+    // each producer's sequence stays in order
+    uint32_t next[2] = {0, 0};
+    for (uint32_t i = 0; i < 2 * this->cnt_; i++) {
+        while (!queue.pop([&next](TypeParam& obj) { EXPECT_EQ(obj.seq, next[obj.uid]++); })) {}
+    }
+    EXPECT_TRUE(this->join(pids[0]));
+    EXPECT_TRUE(this->join(pids[1]));
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <thread>
 
 #include "spsc_queue.hpp"
 #include "tools.hpp"
@@ -7,6 +9,10 @@
 using namespace lfcq;
 using namespace test;
 
+// the blocking interfaces exist only on queues built for them
+template <typename T>
+using WaitableSpscQueue = SpscQueue<T, std::allocator<T>, NoStats, true>;
+
 template <typename T>
 class SpscTest : public testing::Test {
   protected:
@@ -68,6 +74,34 @@ TYPED_TEST(SpscTest, ManualPushInterfaceTest) {
     EXPECT_EQ(this->writer_, this->reader_);
 }
 
+TYPED_TEST(SpscTest, TypeErasedHandleTest) {
+    // the std::function interfaces are kept for compatibility and should behave the same
+    std::thread writer([this]() {
+        for (uint32_t i = 0; i < this->cnt_; i++) {
+            PushHandle<TypeParam> handle = [this, i](TypeParam& dst) {
+                memcpy(&dst.uid, &this->uid_, sizeof(uint32_t));
+                memcpy(&dst.seq, &i, sizeof(uint32_t));
+            };
+            this->queue_.push(std::move(handle));
+            this->writer_.emplace_back(this->uid_, i);
+        }
+    });
+
+    std::thread reader([this]() {
+        for (uint32_t i = 0; i < this->cnt_;) {
+            PopHandle<TypeParam> handle = [this, &i](TypeParam& obj) {
+                this->reader_.emplace_back(obj);
+                i++;
+            };
+            this->queue_.pop(std::move(handle));
+        }
+    });
+
+    writer.join();
+    reader.join();
+    EXPECT_EQ(this->writer_, this->reader_);
+}
+
 TYPED_TEST(SpscTest, EmplaceInterfaceTest) {
     std::thread writer([this]() {
         for (uint32_t i = 0; i < this->cnt_; i++) {
@@ -83,6 +117,173 @@ TYPED_TEST(SpscTest, EmplaceInterfaceTest) {
     EXPECT_EQ(this->writer_, this->reader_);
 }
 
+TYPED_TEST(SpscTest, BulkInterfaceTest) {
+    // bulk interfaces may succeed partially so the rest of a batch is retried
+    std::thread writer([this]() {
+        for (uint32_t i = 0; i < this->cnt_;) {
+            std::vector<TypeParam> batch;
+            uint32_t n = std::min(random(1U, 64U), this->cnt_ - i);
+            for (uint32_t j = 0; j < n; j++) {
+                batch.emplace_back(this->uid_, i + j);
+            }
+            for (auto it = batch.begin(); it != batch.end();) {
+                it += this->queue_.push_bulk(it, batch.end());
+            }
+            this->writer_.insert(this->writer_.end(), batch.begin(), batch.end());
+            i += n;
+        }
+    });
+
+    std::thread reader([this]() {
+        while (this->reader_.size() < this->cnt_) {
+            this->queue_.pop_bulk(std::back_inserter(this->reader_), random(1U, 64U));
+        }
+    });
+
+    writer.join();
+    reader.join();
+    EXPECT_EQ(this->writer_, this->reader_);
+}
+
+// contiguous trivially copyable objects are copied across the wrap of a small ring, streamed in and copied out
+TYPED_TEST(SpscTest, CopyBulkTest) {
+    SpscQueue<TypeParam> queue(64);
+    std::thread writer([this, &queue]() {
+        std::vector<TypeParam> batch;
+        for (uint32_t i = 0; i < this->cnt_;) {
+            batch.clear();
+            uint32_t n = std::min(random(1U, 48U), this->cnt_ - i);
+            for (uint32_t j = 0; j < n; j++) {
+                batch.emplace_back(this->uid_, i + j);
+            }
+            for (TypeParam *it = batch.data(), *end = it + n; it != end;) {
+                it += i % 2 ? queue.push_bulk(it, end) : queue.template push_bulk<CopyMode::Streaming>(it, end);
+            }
+            this->writer_.insert(this->writer_.end(), batch.begin(), batch.end());
+            i += n;
+        }
+    });
+
+    std::thread reader([this, &queue]() {
+        std::vector<TypeParam> buffer(48, TypeParam{0, 0});
+        while (this->reader_.size() < this->cnt_) {
+            uint32_t n = queue.pop_bulk(buffer.data(), random(1U, 48U));
+            this->reader_.insert(this->reader_.end(), buffer.begin(), buffer.begin() + n);
+        }
+    });
+
+    writer.join();
+    reader.join();
+    EXPECT_EQ(this->writer_, this->reader_);
+}
+
+TYPED_TEST(SpscTest, TokenInterfaceTest) {
+    std::thread writer([this]() {
+        for (uint32_t i = 0; i < this->cnt_;) {
+            auto token = this->queue_.reserve();
+            if (!token) continue;
+
+            // fill the slot field by field, it is published when the token goes away
+            token->uid = this->uid_;
+            token->seq = i++;
+            this->writer_.emplace_back(*token);
+        }
+    });
+
+    std::thread reader([this]() {
+        for (uint32_t i = 0; i < this->cnt_;) {
+            auto token = this->queue_.peek();
+            if (!token) continue;
+
+            this->reader_.emplace_back(*token);
+            token.release();
+            EXPECT_FALSE(token);
+            i++;
+        }
+    });
+
+    writer.join();
+    reader.join();
+    EXPECT_EQ(this->writer_, this->reader_);
+
+    // nothing is lent on an empty queue, and a token committed explicitly is published once
+    EXPECT_FALSE(this->queue_.peek());
+    auto token = this->queue_.reserve();
+    *token = TypeParam(this->uid_, 0);
+    token.commit();
+    token.commit();
+    EXPECT_TRUE(this->queue_.pop([](TypeParam&) {}));
+    EXPECT_FALSE(this->queue_.pop([](TypeParam&) {}));
+}
+
+TYPED_TEST(SpscTest, BatchPublishTest) {
+    // writes become visible every 16 pushes, the tail of them only after flushing
+    SpscQueue<TypeParam> queue(this->cnt_, 16);
+
+    std::thread writer([this, &queue]() {
+        for (uint32_t i = 0; i < this->cnt_; i++) {
+            queue.emplace(this->uid_, i);
+            this->writer_.emplace_back(this->uid_, i);
+        }
+        queue.flush();
+    });
+
+    std::thread reader([this, &queue]() {
+        for (uint32_t i = 0; i < this->cnt_;) {
+            queue.pop([this, &i](TypeParam& obj) {
+                this->reader_.emplace_back(obj);
+                i++;
+            });
+        }
+    });
+
+    writer.join();
+    reader.join();
+    EXPECT_EQ(this->writer_, this->reader_);
+}
+
+TYPED_TEST(SpscTest, BlockingInterfaceTest) {
+    // a tiny queue forces both sides to wait for each other frequently
+    WaitableSpscQueue<TypeParam> queue(4);
+
+    std::thread writer([this, &queue]() {
+        for (uint32_t i = 0; i < this->cnt_; i++) {
+            queue.push_wait(TypeParam(this->uid_, i));
+            this->writer_.emplace_back(this->uid_, i);
+        }
+    });
+
+    std::thread reader([this, &queue]() {
+        for (uint32_t i = 0; i < this->cnt_; i++) {
+            queue.pop_wait([this](TypeParam& obj) { this->reader_.emplace_back(obj); });
+        }
+    });
+
+    writer.join();
+    reader.join();
+    EXPECT_EQ(this->writer_, this->reader_);
+}
+
+TYPED_TEST(SpscTest, TimedPopTest) {
+    WaitableSpscQueue<TypeParam> queue(4);
+
+    // nothing has been pushed so the pop must give up
+    auto beg = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_for([](TypeParam&) {}, std::chrono::milliseconds(50)));
+    EXPECT_GE(std::chrono::steady_clock::now() - beg, std::chrono::milliseconds(50));
+
+    // a push arriving while the consumer sleeps should wake it up before the deadline
+    std::thread writer([this, &queue]() {
+        usleep(20'000);
+        queue.emplace(this->uid_, 0U);
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    EXPECT_TRUE(queue.pop_until([this](TypeParam& obj) { EXPECT_EQ(obj.uid, this->uid_); }, deadline));
+    EXPECT_LT(std::chrono::steady_clock::now(), deadline);
+
+    writer.join();
+}
+
 TYPED_TEST(SpscTest, LoopWriteTest) {
     // there will be slots written to more than one times, a.k.a loop write
     this->cnt_ = 4000;
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+#include "static_queue.hpp"
+#include "tools.hpp"
+#include "types.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+template <typename Index>
+class StaticSpscTest : public testing::Test {};
+
+using IndexTypes = testing::Types<uint8_t, uint16_t, uint32_t, uint64_t>;
+TYPED_TEST_SUITE(StaticSpscTest, IndexTypes);
+
+// indices of every width wrap around many times while the order is kept
+TYPED_TEST(StaticSpscTest, OrderTest) {
+    auto queue = std::make_unique<StaticSpscQueue<TrivialObj, 64, TypeParam>>();
+    constexpr uint32_t cnt = 200000;
+
+    std::thread writer([&queue]() {
+        for (uint32_t i = 0; i < cnt; i++) {
+            while (!(i % 2 ? queue->push(TrivialObj{0, i}) : queue->emplace(TrivialObj{0, i}))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (uint32_t i = 0; i < cnt;) {
+        if (std::optional<TrivialObj> obj = queue->try_pop()) {
+            EXPECT_EQ(obj->seq, i++);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    writer.join();
+    EXPECT_EQ(queue->size(), 0);
+}
+
+// a tiny queue lives inside another object, and is full at exactly its capacity
+TEST(StaticSpscTest, EmbeddedTest) {
+    struct Mailbox {
+        uint32_t owner;
+        StaticSpscQueue<uint32_t, 128, uint8_t> queue;
+    } mailbox{7, {}};
+    static_assert(decltype(mailbox.queue)::capacity() == 128);
+
+    for (uint32_t i = 0; i < 128; i++) {
+        EXPECT_TRUE(mailbox.queue.push(i));
+    }
+    EXPECT_FALSE(mailbox.queue.push(128U));
+    EXPECT_EQ(mailbox.queue.size(), 128);
+
+    uint32_t out;
+    EXPECT_TRUE(mailbox.queue.try_pop(out));
+    EXPECT_EQ(out, 0);
+    EXPECT_TRUE(mailbox.queue.push([](uint32_t& obj) { obj = 128; }));
+    for (uint32_t i = 1; i <= 128; i++) {
+        EXPECT_TRUE(mailbox.queue.pop([i](uint32_t& obj) { EXPECT_EQ(obj, i); }));
+    }
+    EXPECT_FALSE(mailbox.queue.try_pop(out));
+    EXPECT_EQ(mailbox.owner, 7);
+}
+
+// elements left in the queue are destructed with it
+TEST(StaticSpscTest, LifetimeTest) {
+    auto counter = std::make_shared<int>(0);
+    {
+        StaticMpmcQueue<std::shared_ptr<int>, 8> mpmc;
+        StaticSpscQueue<std::shared_ptr<int>, 8, uint16_t> spsc;
+        for (uint32_t i = 0; i < 4; i++) {
+            EXPECT_TRUE(mpmc.push(counter));
+            EXPECT_TRUE(spsc.emplace(counter));
+        }
+        EXPECT_TRUE(mpmc.try_pop().has_value());
+        EXPECT_TRUE(spsc.try_pop().has_value());
+        EXPECT_EQ(counter.use_count(), 7);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+template <typename Index>
+class StaticMpmcTest : public testing::Test {};
+
+using WideIndexTypes = testing::Types<uint32_t, uint64_t>;
+TYPED_TEST_SUITE(StaticMpmcTest, WideIndexTypes);
+
+// multiple producers & multiple consumers
+TYPED_TEST(StaticMpmcTest, MpmcTest) {
+    auto queue = std::make_unique<StaticMpmcQueue<NonTrivialObj, 32, TypeParam>>();
+    constexpr uint32_t threads = 3, per_thread = 20000;
+    uint32_t uid = random(0U, UINT32_MAX);
+    std::atomic<uint32_t> w_checksum = 0, r_checksum = 0;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threads; i++) {
+        workers.emplace_back([&, i]() {
+            for (uint32_t j = 0; j < per_thread; j++) {
+                uint32_t seq = i * per_thread + j;
+                while (!queue->emplace(uid, seq)) {
+                    std::this_thread::yield();
+                }
+                w_checksum ^= seq;
+            }
+        });
+        workers.emplace_back([&]() {
+            for (uint32_t j = 0; j < per_thread;) {
+                bool popped = queue->pop([&](NonTrivialObj& obj) {
+                    EXPECT_EQ(obj.uid, uid);
+                    r_checksum ^= obj.seq;
+                });
+                if (popped) {
+                    j++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(w_checksum, r_checksum);
+    EXPECT_EQ(queue->size(), 0);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
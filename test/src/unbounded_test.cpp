@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "tools.hpp"
+#include "types.hpp"
+#include "unbounded_queue.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+/* element counting how many of its kind are alive. */
+struct Counted {
+    static inline std::atomic<int64_t> alive = 0;
+
+    uint32_t uid;
+    uint32_t seq;
+
+    Counted(uint32_t _uid, uint32_t _seq) : uid(_uid), seq(_seq) { alive++; }
+    Counted(const Counted& other) : uid(other.uid), seq(other.seq) { alive++; }
+    ~Counted() { alive--; }
+};
+
+template <typename T>
+class UnboundedTest : public testing::Test {
+  protected:
+    // how many producers / consumers we wish to have simultaneously
+    static constexpr uint32_t multiple_cnt = 3;
+
+    // tiny segments so the queue keeps linking and recycling them
+    UnboundedQueue<T> queue_;
+    uint32_t cnt_;
+    uint32_t uid_;
+
+    std::atomic<uint32_t> w_checksum_;
+    std::atomic<uint32_t> r_checksum_;
+
+    UnboundedTest() : queue_(7, 2), cnt_(30000), uid_(random(0U, UINT32_MAX)), w_checksum_(0), r_checksum_(0) {}
+};
+
+using TestTypes = testing::Types<TrivialObj, NonTrivialObj, Counted>;
+TYPED_TEST_SUITE(UnboundedTest, TestTypes);
+
+// a single producer never gets rejected and its order is kept across segments
+TYPED_TEST(UnboundedTest, GrowTest) {
+    for (uint32_t i = 0; i < this->cnt_; i++) {
+        EXPECT_TRUE(this->queue_.emplace(this->uid_, i));
+    }
+    for (uint32_t i = 0; i < this->cnt_; i++) {
+        EXPECT_TRUE(this->queue_.pop([this, i](TypeParam& obj) {
+            EXPECT_EQ(obj.uid, this->uid_);
+            EXPECT_EQ(obj.seq, i);
+        }));
+    }
+    EXPECT_FALSE(this->queue_.pop([](TypeParam&) {}));
+}
+
+// multiple producers & multiple consumers
+TYPED_TEST(UnboundedTest, MpmcTest) {
+    uint32_t per_thread = this->cnt_ / this->multiple_cnt;
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        workers.emplace_back([this, per_thread]() {
+            for (uint32_t j = 0; j < per_thread; j++) {
+                uint32_t seq = random(0U, UINT32_MAX);
+                this->queue_.push(TypeParam(this->uid_, seq));
+                this->w_checksum_ ^= seq;
+            }
+        });
+        workers.emplace_back([this, per_thread]() {
+            for (uint32_t j = 0; j < per_thread;) {
+                bool popped = this->queue_.pop([this](TypeParam& obj) {
+                    EXPECT_EQ(obj.uid, this->uid_);
+                    this->r_checksum_ ^= obj.seq;
+                });
+                if (popped) {
+                    j++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(this->w_checksum_, this->r_checksum_);
+}
+
+// elements are destructed on pop, and those left are destructed with the queue
+TEST(UnboundedLifetimeTest, DestructTest) {
+    {
+        UnboundedQueue<Counted> queue(4);
+        for (uint32_t i = 0; i < 100; i++) {
+            queue.emplace(0U, i);
+        }
+        EXPECT_EQ(Counted::alive, 100);
+
+        for (uint32_t i = 0; i < 50; i++) {
+            queue.pop([](Counted&) {});
+        }
+        EXPECT_EQ(Counted::alive, 50);
+    }
+    EXPECT_EQ(Counted::alive, 0);
+}
+
+// segments are linked and drained over and over, whether drained ones are released or kept
+TEST(UnboundedLifetimeTest, SpareTest) {
+    for (uint32_t spare : {0U, 1U}) {
+        {
+            UnboundedQueue<Counted> queue(4, spare);
+            for (uint32_t round = 0; round < 10; round++) {
+                for (uint32_t i = 0; i < 20; i++) {
+                    queue.emplace(0U, round * 20 + i);
+                }
+                EXPECT_EQ(Counted::alive, 20);
+
+                for (uint32_t i = 0; i < 20; i++) {
+                    EXPECT_TRUE(queue.pop([](Counted&) {}));
+                }
+                EXPECT_EQ(Counted::alive, 0);
+                EXPECT_FALSE(queue.pop([](Counted&) {}));
+            }
+            queue.emplace(0U, 0U);
+        }
+        EXPECT_EQ(Counted::alive, 0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}
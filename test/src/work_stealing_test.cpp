@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "tools.hpp"
+#include "types.hpp"
+#include "work_stealing_deque.hpp"
+
+using namespace lfcq;
+using namespace test;
+
+/* element wider than any lock-free atomic, so slots are copied plainly. */
+struct WideObj {
+    uint32_t uid;
+    uint32_t seq;
+    uint64_t pad[3];
+
+    WideObj() = default;
+    WideObj(uint32_t _uid, uint32_t _seq) : uid(_uid), seq(_seq), pad{} {}
+};
+
+template <typename T>
+class WorkStealingTest : public testing::Test {
+  protected:
+    // how many thieves we wish to have simultaneously
+    static constexpr uint32_t multiple_cnt = 3;
+
+    // a tiny ring so the owner keeps growing it while thieves are stealing
+    WorkStealingDeque<T> deque_;
+    uint32_t cnt_;
+    uint32_t uid_;
+
+    WorkStealingTest() : deque_(4), cnt_(100000), uid_(random(0U, UINT32_MAX)) {}
+};
+
+using TestTypes = testing::Types<TrivialObj, WideObj>;
+TYPED_TEST_SUITE(WorkStealingTest, TestTypes);
+
+// the owner pops in LIFO order and thieves steal in FIFO order
+TYPED_TEST(WorkStealingTest, OrderTest) {
+    for (uint32_t i = 0; i < 10; i++) {
+        EXPECT_TRUE(this->deque_.push(TypeParam(this->uid_, i)));
+    }
+    EXPECT_EQ(this->deque_.size(), 10);
+    EXPECT_EQ(this->deque_.capacity(), 16);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        EXPECT_TRUE(this->deque_.steal([i](TypeParam& obj) { EXPECT_EQ(obj.seq, i); }));
+    }
+    for (uint32_t i = 10; i-- > 5;) {
+        EXPECT_TRUE(this->deque_.pop([i](TypeParam& obj) { EXPECT_EQ(obj.seq, i); }));
+    }
+    EXPECT_FALSE(this->deque_.pop([](TypeParam&) {}));
+    EXPECT_FALSE(this->deque_.steal([](TypeParam&) {}));
+    EXPECT_EQ(this->deque_.size(), 0);
+}
+
+// without growth the owner is rejected once the ring is full
+TYPED_TEST(WorkStealingTest, FixedTest) {
+    WorkStealingDeque<TypeParam> deque(4, false);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(deque.push([this, i](TypeParam& obj) { obj = TypeParam(this->uid_, i); }));
+    }
+    EXPECT_FALSE(deque.push(TypeParam(this->uid_, 4)));
+
+    EXPECT_TRUE(deque.steal([](TypeParam& obj) { EXPECT_EQ(obj.seq, 0); }));
+    EXPECT_TRUE(deque.push(TypeParam(this->uid_, 4)));
+    EXPECT_EQ(deque.capacity(), 4);
+}
+
+// the owner pushes and pops while thieves steal, every element is taken exactly once
+TYPED_TEST(WorkStealingTest, StressTest) {
+    std::vector<std::atomic<uint8_t>> taken(this->cnt_);
+    std::atomic<uint32_t> total = 0;
+
+    auto take = [&](TypeParam& obj) {
+        EXPECT_EQ(obj.uid, this->uid_);
+        EXPECT_EQ(taken[obj.seq]++, 0);
+        total++;
+    };
+
+    std::vector<std::thread> thieves;
+    for (uint32_t i = 0; i < this->multiple_cnt; i++) {
+        thieves.emplace_back([&]() {
+            while (total < this->cnt_) {
+                if (!this->deque_.steal(take)) std::this_thread::yield();
+            }
+        });
+    }
+
+    // pop one for every few pushed, so the owner often races thieves for the last element
+    for (uint32_t i = 0; i < this->cnt_; i++) {
+        EXPECT_TRUE(this->deque_.push(TypeParam(this->uid_, i)));
+        if (random(0U, 3U) == 0) this->deque_.pop(take);
+    }
+    while (this->deque_.pop(take)) {}
+
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    EXPECT_EQ(total, this->cnt_);
+}
+
+int main(int argc, char* argv[]) {
+    testing::InitGoogleTest(&argc, argv);
+    testing::GTEST_FLAG(color) = "yes";
+    return RUN_ALL_TESTS();
+}